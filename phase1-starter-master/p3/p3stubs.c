@@ -16,7 +16,7 @@
 #define __myassert(e, file, line) \
     (p3mode ? __assert(e, file, line) : p3aborts++)
 
-static int allocated[P1_MAXPROC];
+static int allocated[P1_MAXPROC_LIMIT];
 static int initialized = 0;
 
 int p3mode = 1;
@@ -29,7 +29,7 @@ P3_AllocatePageTable(int pid)
         memset(allocated, 0, sizeof(allocated));
         initialized = 1;
     }
-    myassert((pid >= 0) && (pid < P1_MAXPROC));
+    myassert((pid >= 0) && (pid < P1_MAXPROC_LIMIT));
     myassert(allocated[pid] == 0);
     allocated[pid] = 1;
     return NULL;
@@ -39,7 +39,7 @@ void
 P3_FreePageTable(int pid)
 {
     myassert(initialized);
-    myassert((pid >= 0) && (pid < P1_MAXPROC));
+    myassert((pid >= 0) && (pid < P1_MAXPROC_LIMIT));
     myassert(allocated[pid] == 1);
     allocated[pid] = 0;
 }
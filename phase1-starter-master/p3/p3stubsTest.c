@@ -47,7 +47,7 @@ int main(int argc, char **argv)
     count++;
 
     current = p3aborts;
-    table = P3_AllocatePageTable(P1_MAXPROC);
+    table = P3_AllocatePageTable(P1_MAXPROC_LIMIT);
     CheckAborts(1);
     count++;
 
@@ -57,7 +57,7 @@ int main(int argc, char **argv)
     count++;
 
     current = p3aborts;
-    P3_FreePageTable(P1_MAXPROC);
+    P3_FreePageTable(P1_MAXPROC_LIMIT);
     CheckAborts(1);
     count++;
 
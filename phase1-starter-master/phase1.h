@@ -11,10 +11,12 @@
 #include "usyscall.h"
 
 /*
- * Maximum number of processes.
+ * Maximum number of processes. P1_MAXPROC is the default; P1_SetProcCapacity
+ * can change it at startup, up to P1_MAXPROC_LIMIT.
  */
 
 #define P1_MAXPROC  50
+#define P1_MAXPROC_LIMIT 4096
 
 /*
  * Maximum number of locks and condition variables.
@@ -33,6 +35,13 @@
  * trailing '\0'.
  */
 #define P1_MAXNAME 80
+
+/*
+ * Stride scheduling tickets. A process's share of the CPU among the processes at its
+ * priority is proportional to its tickets. P1_Fork gives P1_DEFAULT_TICKETS.
+ */
+#define P1_DEFAULT_TICKETS 100
+#define P1_MAX_TICKETS 10000
  
 
 /*
@@ -67,12 +76,68 @@ typedef struct P1_ProcInfo {
     int         vid;                    // condition on which process is blocked, if any
     int         priority;               // process's priority
     int         cpu;                    // CPU consumed (in microseconds)
+    int         stackUsed;              // stack high-water mark (in bytes), 0 unless
+                                        // forked with P1StackAutoSize on
     int         parent;                 // parent PID
-    int         children[P1_MAXPROC];   // childen PIDs
-    int         numChildren;            // # of children
+    int         children[P1_MAXPROC];   // childen PIDs, the first P1_MAXPROC of them
+    int         numChildren;            // # of children (may exceed P1_MAXPROC)
 } P1_ProcInfo;
 
 
+/*
+ * One process in a P1_SnapshotProcesses snapshot. pid is always filled in; the other
+ * fields only if requested with the P1_SNAP flags. A process's children are the
+ * processes whose parent is its PID.
+ */
+typedef struct P1_ProcSnapshot {
+    int         pid;
+    char        name[P1_MAXNAME];       // P1_SNAP_NAME
+    P1_State    state;                  // P1_SNAP_STATE
+    int         priority;               // P1_SNAP_PRIORITY
+    int         cpu;                    // P1_SNAP_CPU
+    int         lid;                    // P1_SNAP_BLOCKED
+    int         vid;                    // P1_SNAP_BLOCKED
+    int         parent;                 // P1_SNAP_PARENT
+    int         numChildren;            // P1_SNAP_CHILDREN
+} P1_ProcSnapshot;
+
+#define P1_SNAP_NAME        0x01
+#define P1_SNAP_STATE       0x02
+#define P1_SNAP_PRIORITY    0x04
+#define P1_SNAP_CPU         0x08
+#define P1_SNAP_BLOCKED     0x10
+#define P1_SNAP_PARENT      0x20
+#define P1_SNAP_CHILDREN    0x40
+#define P1_SNAP_ALL         0x7f
+
+/*
+ * Scheduler statistics returned by P1_GetSchedStats, kernel-wide or for one process.
+ * A process's counts are for the P1Dispatch calls made while it was the current
+ * process. The ready queue statistics are kernel-wide only and zero for a process;
+ * the average length is readyTotal / readySamples.
+ */
+typedef struct P1_SchedStats {
+    int         voluntary;              // switches away from a process that blocked or quit
+    int         involuntary;            // switches away from a preempted or rotated process
+    int         noSwitch;               // P1Dispatch calls that didn't switch
+    long long   dispatchTime;           // time spent in P1Dispatch (in microseconds)
+    int         readyMin;               // fewest READY processes seen at a clock tick
+    int         readyMax;               // most READY processes seen at a clock tick
+    long long   readyTotal;             // sum of the READY processes seen at each tick
+    int         readySamples;           // # of clock ticks sampled
+} P1_SchedStats;
+
+/*
+ * One process for P1_ForkMany, with the arguments to P1_Fork.
+ */
+typedef struct P1_ForkSpec {
+    char        *name;
+    int         (*func)(void *);
+    void        *arg;
+    int         stackSize;
+    int         priority;
+} P1_ForkSpec;
+
 
 /*
  * External function prototypes for this phase.
@@ -81,17 +146,29 @@ typedef struct P1_ProcInfo {
 // Phase1b
 extern  int             P1_Fork(char *name, int(*func)(void *), void *arg,
                                 int stackSize, int priority, int *pid) CHECKRETURN;
+extern  int             P1_ForkTickets(char *name, int(*func)(void *), void *arg,
+                                int stackSize, int priority, int tickets, int *pid) CHECKRETURN;
+extern  int             P1_SetTickets(int pid, int tickets) CHECKRETURN;
+extern  int             P1_ForkMany(P1_ForkSpec *specs, int count, int *pids) CHECKRETURN;
 extern  void            P1_Quit(int status);
 extern  int             P1_GetPid(void) CHECKRETURN;
 extern  int             P1_GetProcInfo(int pid, P1_ProcInfo *info) CHECKRETURN;
+extern  int             P1_GetChildren(int pid, int *buf, int max, int *count) CHECKRETURN;
+extern  int             P1_SnapshotProcesses(P1_ProcSnapshot *buf, int cap, int fields,
+                                int *count) CHECKRETURN;
+extern  int             P1_SetProcCapacity(int capacity) CHECKRETURN;
+extern  int             P1_GetSchedStats(int pid, P1_SchedStats *stats) CHECKRETURN;
 
 extern  int             P1_Join(int *pid, int *status) CHECKRETURN;
+extern  int             P1_JoinPid(int pid, int *status) CHECKRETURN;
+extern  int             P1_TryJoin(int *pid, int *status) CHECKRETURN;
 
 extern  int             P1_LockCreate(char *name, int *lid) CHECKRETURN;
 extern  int             P1_LockFree(int lid) CHECKRETURN;
 extern  int             P1_Lock(int lid) CHECKRETURN;
 extern  int             P1_Unlock(int lid) CHECKRETURN;
 extern  int             P1_LockName(int lid, char *name, int len) CHECKRETURN;
+extern  int             P1_LockFind(char *name, int *lid) CHECKRETURN;
 extern  int             P1_CondCreate(char *name, int lid, int *vid) CHECKRETURN;
 extern  int             P1_CondFree(int vid) CHECKRETURN;
 extern  int             P1_Wait(int vid) CHECKRETURN;
@@ -99,6 +176,7 @@ extern  int             P1_Signal(int vid) CHECKRETURN;
 extern  int             P1_Broadcast(int vid) CHECKRETURN;
 extern  int             P1_NakedSignal(int vid) CHECKRETURN;
 extern  int             P1_CondName(int vid, char *name, int len) CHECKRETURN;
+extern  int             P1_CondFind(char *name, int *vid) CHECKRETURN;
 extern  int             P1_DeviceWait(int type, int unit, int *status) CHECKRETURN;
 extern int              P1_DeviceAbort(int type, int unit) CHECKRETURN;
 
@@ -134,5 +212,7 @@ extern  int             P2_Startup(void *arg) CHECKRETURN;
 #define P1_NAME_TOO_LONG -22
 #define P1_CONTEXT_IN_USE -23
 #define P1_LOCK_HELD -24
+#define P1_INVALID_QUANTUM -25
+#define P1_INVALID_TICKETS -26
 
 #endif /* _PHASE1_H */
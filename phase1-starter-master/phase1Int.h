@@ -7,12 +7,170 @@
 #ifndef _PHASE1_INT_H
 #define _PHASE1_INT_H
 
+#include <string.h>
 #include "phase1.h"
+#include "phase1Trace.h"
 
 #ifndef CHECKRETURN
 #define CHECKRETURN __attribute__((warn_unused_result))
 #endif
 
+/*
+ * Free-slot bitmaps for the process, context, lock, and condition tables. A set bit
+ * means the slot is free. summary has a bit set for each word of words[] that
+ * contains a free slot, so allocating the lowest free slot is two find-first-set
+ * operations and freeing a slot is two bit sets, whatever the size of the table.
+ */
+
+#define P1_BITMAP_BITS  64
+#define P1_BITMAP_MAX   (P1_BITMAP_BITS * P1_BITMAP_BITS)
+
+typedef struct P1Bitmap {
+    unsigned long long  summary;
+    unsigned long long  words[P1_BITMAP_BITS];
+} P1Bitmap;
+
+// Marks slots [0, n) free and all others in use.
+static inline void
+P1BitmapInit(P1Bitmap *map, int n)
+{
+    map->summary = 0;
+    for (int i = 0; i < P1_BITMAP_BITS; i++) {
+        map->words[i] = 0;
+    }
+    for (int i = 0; i < n; i++) {
+        map->words[i / P1_BITMAP_BITS] |= 1ULL << (i % P1_BITMAP_BITS);
+        map->summary |= 1ULL << (i / P1_BITMAP_BITS);
+    }
+}
+
+// Allocates the lowest free slot. Returns -1 if there are none.
+static inline int
+P1BitmapAlloc(P1Bitmap *map)
+{
+    int w, b;
+
+    if (map->summary == 0) {
+        return -1;
+    }
+    w = __builtin_ctzll(map->summary);
+    b = __builtin_ctzll(map->words[w]);
+    map->words[w] &= ~(1ULL << b);
+    if (map->words[w] == 0) {
+        map->summary &= ~(1ULL << w);
+    }
+    return w * P1_BITMAP_BITS + b;
+}
+
+static inline void
+P1BitmapFree(P1Bitmap *map, int slot)
+{
+    map->words[slot / P1_BITMAP_BITS] |= 1ULL << (slot % P1_BITMAP_BITS);
+    map->summary |= 1ULL << (slot / P1_BITMAP_BITS);
+}
+
+/*
+ * Hash index from names to process, lock, or condition ids, so creating and finding
+ * an object doesn't compare its name against every other object. Open addressing
+ * with linear probing; removal shifts later entries back rather than leaving
+ * tombstones, so lookups stay short however many objects come and go. The index
+ * points at each object's own copy of its name, which must not move.
+ */
+
+#define P1_NAME_INDEX_SIZE  8192    // power of 2, at least twice any table
+
+#if P1_NAME_INDEX_SIZE < 2 * P1_MAXPROC_LIMIT || P1_NAME_INDEX_SIZE < 2 * P1_MAXLOCKS || \
+    P1_NAME_INDEX_SIZE < 2 * P1_MAXCONDS
+#error "P1_NAME_INDEX_SIZE is too small"
+#endif
+
+typedef struct P1NameEntry {
+    char            *name;          // the object's own name, NULL if unused
+    unsigned int    hash;
+    int             id;
+} P1NameEntry;
+
+typedef struct P1NameIndex {
+    P1NameEntry     entries[P1_NAME_INDEX_SIZE];
+} P1NameIndex;
+
+static inline void
+P1NameIndexInit(P1NameIndex *index)
+{
+    for (int i = 0; i < P1_NAME_INDEX_SIZE; i++) {
+        index->entries[i].name = NULL;
+    }
+}
+
+static inline unsigned int
+P1NameHash(char *name)
+{
+    unsigned int hash = 2166136261u;        // FNV-1a
+
+    for (; *name != '\0'; name++) {
+        hash = (hash ^ (unsigned char) *name) * 16777619u;
+    }
+    return hash;
+}
+
+// Returns the index of the entry for name, or of the empty entry where it would go.
+static inline int
+P1NameIndexSlot(P1NameIndex *index, char *name, unsigned int hash)
+{
+    int i = hash & (P1_NAME_INDEX_SIZE - 1);
+
+    while (index->entries[i].name != NULL) {
+        if ((index->entries[i].hash == hash) && (strcmp(index->entries[i].name, name) == 0)) {
+            break;
+        }
+        i = (i + 1) & (P1_NAME_INDEX_SIZE - 1);
+    }
+    return i;
+}
+
+// Returns the id of the object named name, or -1 if there isn't one.
+static inline int
+P1NameIndexFind(P1NameIndex *index, char *name)
+{
+    P1NameEntry *entry = &index->entries[P1NameIndexSlot(index, name, P1NameHash(name))];
+
+    return (entry->name == NULL) ? -1 : entry->id;
+}
+
+// name must be the object's own copy, which the index points to.
+static inline void
+P1NameIndexInsert(P1NameIndex *index, char *name, int id)
+{
+    unsigned int hash = P1NameHash(name);
+    P1NameEntry *entry = &index->entries[P1NameIndexSlot(index, name, hash)];
+
+    entry->name = name;
+    entry->hash = hash;
+    entry->id = id;
+}
+
+static inline void
+P1NameIndexRemove(P1NameIndex *index, char *name)
+{
+    int i = P1NameIndexSlot(index, name, P1NameHash(name));
+    int j = i;
+    int home;
+
+    // move back any later entry in the run that can't be found past the hole
+    while (1) {
+        j = (j + 1) & (P1_NAME_INDEX_SIZE - 1);
+        if (index->entries[j].name == NULL) {
+            break;
+        }
+        home = index->entries[j].hash & (P1_NAME_INDEX_SIZE - 1);
+        if (((j - home) & (P1_NAME_INDEX_SIZE - 1)) >= ((j - i) & (P1_NAME_INDEX_SIZE - 1))) {
+            index->entries[i] = index->entries[j];
+            i = j;
+        }
+    }
+    index->entries[i].name = NULL;
+}
+
 
 // Phase 1a
 
@@ -20,15 +178,111 @@ void    P1ContextInit(void);
 int     P1ContextCreate(void (*func)(void *), void *arg, int stacksize, int *cid) CHECKRETURN;
 int     P1ContextSwitch(int cid) CHECKRETURN;
 int     P1ContextFree(int cid) CHECKRETURN;
+int     P1ContextStackUsage(int cid, int *used) CHECKRETURN;
+void    P1ContextMeasureStacks(int enable);
 int     P1DisableInterrupts(void) CHECKRETURN;
 void    P1EnableInterrupts(void);
 
+/*
+ * Stack pool used by P1ContextCreate/P1ContextFree. P1_STACK_POOL_CAP is the
+ * default number of free stacks retained per size class.
+ */
+
+#define P1_STACK_POOL_CAP 16
+
+typedef struct P1StackPoolStats {
+    int     hits;       // stacks handed out from the pool
+    int     misses;     // stacks that had to be allocated
+    int     retained;   // stacks currently in the pool
+    int     released;   // freed stacks returned to the allocator because the pool was full
+} P1StackPoolStats;
+
+void    P1StackPoolConfig(int cap);
+void    P1StackPoolGetStats(P1StackPoolStats *stats);
+
 // Phase 1b
 
+/*
+ * A PID is a process table slot in the low P1_PID_SLOT_BITS bits with the slot's
+ * generation above them, so a slot's next process gets a different PID. Phase 1b
+ * rejects PIDs whose generation is stale.
+ */
+
+#define P1_PID_SLOT_BITS 12
+
+#if P1_MAXPROC_LIMIT > (1 << P1_PID_SLOT_BITS)
+#error "P1_PID_SLOT_BITS is too small for P1_MAXPROC_LIMIT"
+#endif
+
+static inline int
+P1PidSlot(int pid)
+{
+    return pid & ((1 << P1_PID_SLOT_BITS) - 1);
+}
+
+/*
+ * Scheduling policies for P1ProcInitPolicy. P1ProcInit uses P1_SCHED_PRIORITY.
+ */
+
+typedef enum P1SchedPolicy {
+    P1_SCHED_PRIORITY,      // fixed priority, round-robin within a priority
+    P1_SCHED_MLFQ,          // multi-level feedback queue, fork priority is a ceiling
+    P1_SCHED_STRIDE,        // stride scheduling by tickets within a priority
+} P1SchedPolicy;
+
 void    P1ProcInit(void);
+void    P1ProcInitPolicy(P1SchedPolicy policy);
 int     P1GetChildStatus(int *cpid, int *status) CHECKRETURN;
+int     P1GetChildStatuses(int *cpids, int *statuses, int max, int *count) CHECKRETURN;
+int     P1GetChildStatusPid(int cpid, int *status) CHECKRETURN;
+int     P1SetJoiningPid(int cpid) CHECKRETURN;
 int     P1SetState(int pid, P1_State state, int lid, int vid) CHECKRETURN;
+int     P1SetBlockedOn(int pid, int lid, int vid) CHECKRETURN;
 void    P1Dispatch(int rotate);
+void    P1StackAutoSize(int enable);
+int     P1GetPriority(int pid);
+void    P1SetQuitHook(void (*hook)(int pid));
+
+/*
+ * Time quanta, in clock ticks. The clock interrupt handler calls P1Tick.
+ */
+
+#define P1_DEFAULT_QUANTUM 4
+
+void    P1Tick(void);
+int     P1SetQuantum(int priority, int ticks) CHECKRETURN;
+void    P1SetAdaptiveQuantum(int enable);
+int     P1GetRotationsAvoided(void);
+int     P1SetInheritedPriority(int pid, int priority) CHECKRETURN;
+
+/*
+ * Kernel-wide CPU time not charged to any process, in microseconds.
+ */
+
+typedef struct P1CpuStats {
+    long long   interrupt;  // time spent in device interrupt handlers
+    long long   idle;       // time the sentinel spent waiting for an interrupt
+} P1CpuStats;
+
+void    P1InterruptEnter(void);
+void    P1InterruptExit(void);
+void    P1Idle(int waiting);
+void    P1GetCpuStats(P1CpuStats *stats);
+
+/*
+ * Histogram of the time from the start of an interrupt handler that wakes a process
+ * to when that process runs. Bucket 0 counts latencies under a microsecond, bucket
+ * i those in [2^(i-1), 2^i) microseconds, and the last bucket everything longer.
+ */
+
+#define P1_LATENCY_BUCKETS 16
+
+void    P1GetWakeLatency(int *buckets);
+
+// Scheduler trace, recorded when built with -DP1_TRACE. See phase1Trace.h.
+
+int     P1TraceSnapshot(P1TraceEvent *events, int max);
+int     P1TraceDump(char *path);
 
 // Phase 1c
 
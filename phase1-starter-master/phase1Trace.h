@@ -0,0 +1,57 @@
+/*
+ * Scheduler trace format. Shared by the kernel, which records events when built
+ * with -DP1_TRACE, and the host-side decoder in tools/p1trace.c.
+ */
+
+#ifndef _PHASE1_TRACE_H
+#define _PHASE1_TRACE_H
+
+/*
+ * Number of events kept in the ring buffer. Must be a power of two.
+ */
+
+#define P1_TRACE_SIZE   4096
+
+/*
+ * Event types.
+ */
+
+#define P1_TRACE_SWITCH 0       // pid is the outgoing process, other the incoming, arg the reason
+#define P1_TRACE_STATE  1       // pid changed from state other to state arg via P1SetState
+#define P1_TRACE_FORK   2       // pid forked other at priority arg
+#define P1_TRACE_QUIT   3       // pid quit with status other
+
+/*
+ * Context switch reasons.
+ */
+
+#define P1_TRACE_START      0   // first dispatch, there is no outgoing process
+#define P1_TRACE_PREEMPT    1   // a higher-priority process became ready
+#define P1_TRACE_ROTATE     2   // time slice rotation among equal priorities
+#define P1_TRACE_BLOCK      3   // outgoing process blocked or is joining
+#define P1_TRACE_EXIT       4   // outgoing process quit
+
+typedef struct P1TraceEvent {
+    unsigned int    time;       // USLOSS clock (in microseconds)
+    unsigned short  type;
+    unsigned short  arg;
+    int             pid;
+    int             other;
+} P1TraceEvent;
+
+/*
+ * A dump file is a P1TraceHeader followed by count events, oldest first. dropped is
+ * the number of older events that were overwritten before the dump.
+ */
+
+#define P1_TRACE_MAGIC      0x52543150  // "P1TR"
+#define P1_TRACE_VERSION    1
+
+typedef struct P1TraceHeader {
+    unsigned int    magic;
+    unsigned int    version;
+    unsigned int    count;
+    unsigned int    dropped;
+} P1TraceHeader;
+
+#endif
@@ -1,8 +1,13 @@
 #include "phase1Int.h"
 #include "usloss.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <stdio.h>
+#ifdef MMAP_STACKS
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 extern  USLOSS_PTE  *P3_AllocatePageTable(int cid);
 extern  void        P3_FreePageTable(int cid);
@@ -11,61 +16,522 @@ typedef struct Context {
     void            (*startFunc)(void *);
     void            *startArg;
     USLOSS_Context  context;
-    // you'll need more stuff here
+    int             inuse;          // TRUE if the context has been created and not freed
+    char            *stack;         // the context's stack
+    int             stackSize;      // size of the stack, rounded up to its size class
+    int             stackUsed;      // stack high-water mark, measured when the context is freed
+    int             measured;       // TRUE if the stack was prepared for measuring
 } Context;
 
-static Context   contexts[P1_MAXPROC];
+/*
+ * The context table grows CONTEXT_CHUNK contexts at a time, up to P1_MAXPROC_LIMIT.
+ * Chunks are never moved or freed so a saved USLOSS_Context stays put.
+ */
+
+#define CONTEXT_CHUNK   P1_BITMAP_BITS
+
+static Context   *contexts[P1_MAXPROC_LIMIT / CONTEXT_CHUNK];
+static int       numContexts = 0;       // # of contexts in the table
+static P1Bitmap  freeContexts;          // free slots in contexts
+
+static inline Context *
+Ctx(int cid)
+{
+    return &contexts[cid / CONTEXT_CHUNK][cid % CONTEXT_CHUNK];
+}
+
+/*
+ * Adds a chunk of free contexts to the table. Returns FALSE if it can't.
+ */
+static int
+GrowContexts(void)
+{
+    int     chunk = numContexts / CONTEXT_CHUNK;
+
+    if (numContexts >= P1_MAXPROC_LIMIT) {
+        return FALSE;
+    }
+    if (contexts[chunk] == NULL) {
+        contexts[chunk] = malloc(CONTEXT_CHUNK * sizeof(Context));
+        if (contexts[chunk] == NULL) {
+            return FALSE;
+        }
+    }
+    for (int i = numContexts; i < numContexts + CONTEXT_CHUNK; i++) {
+        Ctx(i)->inuse = FALSE;
+        Ctx(i)->stack = NULL;
+        Ctx(i)->stackUsed = 0;
+        P1BitmapFree(&freeContexts, i);
+    }
+    numContexts += CONTEXT_CHUNK;
+    return TRUE;
+}
 
 static int currentCid = -1;
 
+/*
+ * Stack pool. Freed stacks are kept on per-size-class free lists and handed back
+ * by the next P1ContextCreate of the same class, so fork/quit churn doesn't go
+ * through malloc/free. Class i holds stacks of USLOSS_MIN_STACK << i bytes; larger
+ * requests bypass the pool. A free stack's list link is stored in the stack itself.
+ *
+ * The stack backend measures how much of a stack a context touched, see
+ * StackUsage. A pooled stack remembers how much of it was dirtied so only that
+ * part is prepared again for its next owner.
+ */
+
+#define STACK_CLASSES   4
+
+typedef struct FreeStack {
+    struct FreeStack    *next;
+    int                 dirty;      // bytes at the top of the stack that need repainting
+} FreeStack;
+
+static int              measureStacks;                  // see P1ContextMeasureStacks
+static FreeStack        *freeStacks[STACK_CLASSES];     // free list per size class
+static int              numFree[STACK_CLASSES];         // length of each free list
+static int              stackPoolCap = P1_STACK_POOL_CAP;
+static P1StackPoolStats poolStats;
+
+/*
+ * Stack backend. By default stacks come from malloc. If MMAP_STACKS is defined each
+ * stack is reserved with mmap(MAP_NORESERVE) with a PROT_NONE guard page below it,
+ * so physical memory is only committed for pages the process touches and a stack
+ * overflow faults immediately instead of corrupting a neighbouring allocation.
+ */
+
+#ifdef MMAP_STACKS
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+#define MINCORE_PAGES   64          // pages asked about per mincore call
+
+static long pageSize;
+
+static int
+PageRound(int size)
+{
+    return (size + pageSize - 1) & ~(pageSize - 1);
+}
+
+static char *
+StackAlloc(int size)
+{
+    char    *base;
+
+    if (pageSize == 0) {
+        pageSize = sysconf(_SC_PAGESIZE);
+    }
+    base = mmap(NULL, PageRound(size) + pageSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+    if (mprotect(base, pageSize, PROT_NONE) != 0) {
+        munmap(base, PageRound(size) + pageSize);
+        return NULL;
+    }
+    return base + pageSize;
+}
+
+static void
+StackRelease(char *stack, int size)
+{
+    int rc = munmap(stack - pageSize, PageRound(size) + pageSize);
+    assert(rc == 0);
+}
+
+/*
+ * Called when a stack is put in the pool. Gives its pages back to the OS; they
+ * read as zero and are committed again only when the next owner touches them.
+ */
+static void
+StackDecommit(char *stack, int size)
+{
+    int rc = madvise(stack, PageRound(size), MADV_DONTNEED);
+    assert(rc == 0);
+}
+
+/*
+ * Called when a stack is taken from the pool. The free list link was written to its
+ * bottom page after it was decommitted, so decommit that page again.
+ */
+static void
+StackUnlink(char *stack)
+{
+    int rc = madvise(stack, pageSize, MADV_DONTNEED);
+    assert(rc == 0);
+}
+
+// Fresh and decommitted pages aren't resident, so there is nothing to prepare.
+static void
+StackPaint(char *stack, int size, int dirty) {}
+
+/*
+ * Returns the number of bytes at the top of the stack that have been touched, i.e.
+ * the distance from the top of the stack to the bottom of the deepest resident page.
+ * Pages are only resident once touched, whatever was written to them.
+ */
+static int
+StackUsage(char *stack, int size)
+{
+    unsigned char   resident[MINCORE_PAGES];
+    int             pages = PageRound(size) / pageSize;
+    int             n;
+    int             rc;
+
+    for (int page = 0; page < pages; page += n) {
+        n = pages - page;
+        if (n > MINCORE_PAGES) {
+            n = MINCORE_PAGES;
+        }
+        rc = mincore(stack + page * pageSize, n * pageSize, resident);
+        assert(rc == 0);
+        for (int i = 0; i < n; i++) {
+            if (resident[i] & 1) {
+                return size - (page + i) * pageSize;
+            }
+        }
+    }
+    return 0;
+}
+
+#else
+
+#define STACK_PAINT     0xa5
+
+static char *
+StackAlloc(int size)
+{
+    return malloc(size);
+}
+
+static void
+StackRelease(char *stack, int size)
+{
+    free(stack);
+}
+
+static void
+StackDecommit(char *stack, int size) {}
+
+// Called when a stack is taken from the pool. Repaints its free list link.
+static void
+StackUnlink(char *stack)
+{
+    memset(stack, STACK_PAINT, sizeof(FreeStack));
+}
+
+/*
+ * Stacks are painted with STACK_PAINT before use so the deepest byte a context
+ * touched can be found later by scanning up from the bottom of the stack. Paints
+ * the dirty bytes at the top of the stack.
+ */
+static void
+StackPaint(char *stack, int size, int dirty)
+{
+    memset(stack + size - dirty, STACK_PAINT, dirty);
+}
+
+/*
+ * Returns the number of bytes at the top of the stack that have been touched, i.e.
+ * the distance from the top of the stack to the deepest byte that isn't STACK_PAINT.
+ */
+static int
+StackUsage(char *stack, int size)
+{
+    static char painted[256];
+    int         offset = 0;
+
+    if (painted[0] != (char) STACK_PAINT) {
+        memset(painted, STACK_PAINT, sizeof(painted));
+    }
+    while ((offset + sizeof(painted) <= size) &&
+           (memcmp(stack + offset, painted, sizeof(painted)) == 0)) {
+        offset += sizeof(painted);
+    }
+    while ((offset < size) && (stack[offset] == (char) STACK_PAINT)) {
+        offset++;
+    }
+    return size - offset;
+}
+
+#endif
+
+/*
+ * Returns the size class for a stack of the given size, or -1 if it is too big to pool.
+ */
+static int
+StackClass(int size)
+{
+    for (int i = 0; i < STACK_CLASSES; i++) {
+        if (size <= (USLOSS_MIN_STACK << i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Allocates a stack of at least size bytes, preferably from the pool, and prepares
+ * it for measuring if measure is TRUE. The actual size of the stack is returned in
+ * *actual.
+ */
+static char *
+StackGet(int size, int *actual, int measure)
+{
+    int     class = StackClass(size);
+    char    *stack;
+    int     dirty;
+
+    if (class == -1) {
+        *actual = size;
+        stack = StackAlloc(size);
+        dirty = size;
+    } else if (freeStacks[class] != NULL) {
+        *actual = USLOSS_MIN_STACK << class;
+        stack = (char *) freeStacks[class];
+        freeStacks[class] = freeStacks[class]->next;
+        dirty = ((FreeStack *) stack)->dirty;
+        StackUnlink(stack);
+        numFree[class]--;
+        poolStats.hits++;
+        poolStats.retained--;
+    } else {
+        *actual = USLOSS_MIN_STACK << class;
+        stack = StackAlloc(*actual);
+        dirty = *actual;
+        poolStats.misses++;
+    }
+    if ((stack != NULL) && measure) {
+        StackPaint(stack, *actual, dirty);
+    }
+    return stack;
+}
+
+/*
+ * Returns a stack to the pool, or to the allocator if its class is full. used is
+ * the stack's high-water mark, or its size if it wasn't measured.
+ */
+static void
+StackPut(char *stack, int size, int used)
+{
+    int     class = StackClass(size);
+
+    if ((class == -1) || (numFree[class] >= stackPoolCap)) {
+        if (class != -1) {
+            poolStats.released++;
+        }
+        StackRelease(stack, size);
+        return;
+    }
+    StackDecommit(stack, size);
+    ((FreeStack *) stack)->next = freeStacks[class];
+    ((FreeStack *) stack)->dirty = used;
+    freeStacks[class] = (FreeStack *) stack;
+    numFree[class]++;
+    poolStats.retained++;
+}
+
 /*
  * Helper function to call func passed to P1ContextCreate with its arg.
  */
 static void launch(void)
 {
-    assert(contexts[currentCid].startFunc != NULL);
-    contexts[currentCid].startFunc(contexts[currentCid].startArg);
+    assert(Ctx(currentCid)->startFunc != NULL);
+    Ctx(currentCid)->startFunc(Ctx(currentCid)->startArg);
 }
 
 void P1ContextInit(void)
 {
-    // initialize contexts
+    // contexts are initialized as the table grows
+    P1BitmapInit(&freeContexts, 0);
+    numContexts = 0;
+    currentCid = -1;
 }
 
 int P1ContextCreate(void (*func)(void *), void *arg, int stacksize, int *cid) {
     int result = P1_SUCCESS;
+    int i;
+    int enabled;
+    Context *context;
+
+    if (stacksize < USLOSS_MIN_STACK) {
+        return P1_INVALID_STACK;
+    }
+    enabled = P1DisableInterrupts();
     // find a free context and initialize it
+    i = P1BitmapAlloc(&freeContexts);
+    if ((i == -1) && GrowContexts()) {
+        i = P1BitmapAlloc(&freeContexts);
+    }
+    if (i == -1) {
+        result = P1_TOO_MANY_CONTEXTS;
+        goto done;
+    }
     // allocate the stack, specify the startFunc, etc.
+    context = Ctx(i);
+    context->measured = measureStacks;
+    context->stack = StackGet(stacksize, &context->stackSize, context->measured);
+    if (context->stack == NULL) {
+        P1BitmapFree(&freeContexts, i);
+        result = P1_INVALID_STACK;
+        goto done;
+    }
+    context->startFunc = func;
+    context->startArg = arg;
+    context->inuse = TRUE;
+    context->stackUsed = 0;
+    USLOSS_ContextInit(&context->context, context->stack, context->stackSize,
+                       P3_AllocatePageTable(i), launch);
+    *cid = i;
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
     return result;
 }
 
 int P1ContextSwitch(int cid) {
     int result = P1_SUCCESS;
+    int old;
+
+    if ((cid < 0) || (cid >= numContexts) || !Ctx(cid)->inuse) {
+        return P1_INVALID_CID;
+    }
     // switch to the specified context
+    old = currentCid;
+    currentCid = cid;
+    USLOSS_ContextSwitch((old == -1) ? NULL : &Ctx(old)->context, &Ctx(cid)->context);
     return result;
 }
 
 int P1ContextFree(int cid) {
     int result = P1_SUCCESS;
+    int enabled;
+
+    if ((cid < 0) || (cid >= numContexts) || !Ctx(cid)->inuse) {
+        return P1_INVALID_CID;
+    }
+    if (cid == currentCid) {
+        return P1_CONTEXT_IN_USE;
+    }
     // free the stack and mark the context as unused
+    enabled = P1DisableInterrupts();
+    if (Ctx(cid)->measured) {
+        Ctx(cid)->stackUsed = StackUsage(Ctx(cid)->stack, Ctx(cid)->stackSize);
+        StackPut(Ctx(cid)->stack, Ctx(cid)->stackSize, Ctx(cid)->stackUsed);
+    } else {
+        Ctx(cid)->stackUsed = 0;
+        StackPut(Ctx(cid)->stack, Ctx(cid)->stackSize, Ctx(cid)->stackSize);
+    }
+    Ctx(cid)->stack = NULL;
+    Ctx(cid)->inuse = FALSE;
+    P1BitmapFree(&freeContexts, cid);
+    P3_FreePageTable(cid);
+    if (enabled) {
+        P1EnableInterrupts();
+    }
     return result;
 }
 
+/*
+ * Returns the stack high-water mark of the context in *used. If the context has
+ * been freed this is the value measured by P1ContextFree. It is 0 for a context
+ * created while stack measurement was off.
+ */
+int
+P1ContextStackUsage(int cid, int *used)
+{
+    int result = P1_SUCCESS;
+
+    if ((cid < 0) || (cid >= numContexts)) {
+        return P1_INVALID_CID;
+    }
+    int enabled = P1DisableInterrupts();
+    if (Ctx(cid)->inuse && Ctx(cid)->measured) {
+        *used = StackUsage(Ctx(cid)->stack, Ctx(cid)->stackSize);
+    } else if (Ctx(cid)->inuse) {
+        *used = 0;
+    } else {
+        *used = Ctx(cid)->stackUsed;
+    }
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+/*
+ * Turns stack measurement on or off for contexts created from now on. Measuring
+ * costs time in proportion to the stack size on every create and free, so it is
+ * off by default; P1StackAutoSize turns it on.
+ */
+void
+P1ContextMeasureStacks(int enable)
+{
+    measureStacks = enable;
+}
+
+/*
+ * Sets the maximum number of free stacks retained per size class. Stacks beyond
+ * the new cap are released immediately.
+ */
+void
+P1StackPoolConfig(int cap)
+{
+    int enabled = P1DisableInterrupts();
+
+    stackPoolCap = (cap < 0) ? 0 : cap;
+    for (int i = 0; i < STACK_CLASSES; i++) {
+        while (numFree[i] > stackPoolCap) {
+            FreeStack *stack = freeStacks[i];
+            freeStacks[i] = stack->next;
+            numFree[i]--;
+            poolStats.retained--;
+            poolStats.released++;
+            StackRelease((char *) stack, USLOSS_MIN_STACK << i);
+        }
+    }
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+}
+
+void
+P1StackPoolGetStats(P1StackPoolStats *stats)
+{
+    int enabled = P1DisableInterrupts();
+    *stats = poolStats;
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+}
 
-void 
-P1EnableInterrupts(void) 
+void
+P1EnableInterrupts(void)
 {
     // set the interrupt bit in the PSR
+    int rc = USLOSS_PsrSet(USLOSS_PsrGet() | USLOSS_PSR_CURRENT_INT);
+    assert(rc == USLOSS_ERR_OK);
 }
 
 /*
  * Returns true if interrupts were enabled, false otherwise.
  */
-int 
-P1DisableInterrupts(void) 
+int
+P1DisableInterrupts(void)
 {
     int enabled = FALSE;
+    int psr = USLOSS_PsrGet();
     // set enabled to TRUE if interrupts are already enabled
+    if (psr & USLOSS_PSR_CURRENT_INT) {
+        enabled = TRUE;
+    }
     // clear the interrupt bit in the PSR
+    int rc = USLOSS_PsrSet(psr & ~USLOSS_PSR_CURRENT_INT);
+    assert(rc == USLOSS_ERR_OK);
     return enabled;
 }
@@ -0,0 +1,102 @@
+/*
+ * Tests the mmap stack backend, whatever the build's CFLAGS. The test is compiled
+ * together with phase1a.c and MMAP_STACKS defined, so the linker doesn't pull
+ * phase1a from the library. Contexts run on mmap'd stacks, measure their stack
+ * usage, and are freed into the pool and reused from it. Third writes zeroes, which
+ * must count as used like any other data.
+ */
+
+#ifndef MMAP_STACKS
+#define MMAP_STACKS
+#endif
+#include "../phase1a.c"
+#include "tester.h"
+
+#define DEPTH 8000
+
+static int first, second, third;
+
+// touches DEPTH bytes of stack with value and returns the context's stack usage
+static int
+Touch(char value)
+{
+    volatile char buf[DEPTH];
+    int used;
+    int rc;
+
+    memset((char *) buf, value, sizeof(buf));
+    rc = P1ContextStackUsage(currentCid, &used);
+    TEST(rc, P1_SUCCESS);
+    return used + buf[0] - value;
+}
+
+static void
+Third(void *arg)
+{
+    int used = Touch(0);
+    TEST(used >= DEPTH, 1);
+    TEST(used < 2 * USLOSS_MIN_STACK, 1);
+    PASSED();
+}
+
+static void
+Second(void *arg)
+{
+    int used, rc;
+    P1StackPoolStats stats;
+
+    // First's stack goes back to the pool and is handed to Third
+    rc = P1ContextFree(first);
+    TEST(rc, P1_SUCCESS);
+    rc = P1ContextStackUsage(first, &used);
+    TEST(rc, P1_SUCCESS);
+    TEST(used >= DEPTH, 1);
+    P1StackPoolGetStats(&stats);
+    TEST(stats.retained, 1);
+    rc = P1ContextCreate(Third, NULL, 2 * USLOSS_MIN_STACK, &third);
+    TEST(rc, P1_SUCCESS);
+    P1StackPoolGetStats(&stats);
+    TEST(stats.hits, 1);
+    TEST(stats.retained, 0);
+    rc = P1ContextSwitch(third);
+    // should not return
+    FAILED(1,0);
+}
+
+static void
+First(void *arg)
+{
+    int used = Touch(1);
+    int rc;
+
+    TEST(used >= DEPTH, 1);
+    TEST(used < 2 * USLOSS_MIN_STACK, 1);
+    rc = P1ContextCreate(Second, NULL, USLOSS_MIN_STACK, &second);
+    TEST(rc, P1_SUCCESS);
+    rc = P1ContextSwitch(second);
+    // should not return
+    FAILED(1,0);
+}
+
+void
+startup(int argc, char **argv)
+{
+    int rc;
+
+    P1ContextInit();
+    P1ContextMeasureStacks(TRUE);
+    rc = P1ContextCreate(First, NULL, 2 * USLOSS_MIN_STACK, &first);
+    TEST(rc, P1_SUCCESS);
+    // the stack came from mmap, page-aligned above its guard page
+    TEST(pageSize > 0, 1);
+    TEST((long) Ctx(first)->stack % pageSize, 0);
+    rc = P1ContextSwitch(first);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
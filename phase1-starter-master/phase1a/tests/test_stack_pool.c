@@ -0,0 +1,73 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include "tester.h"
+
+/*
+ * Tests the stack pool. A freed stack should be reused by the next create of the
+ * same size class, other classes should miss, and a cap of 0 should release stacks.
+ * Stack measurement is off, so freed contexts report no stack usage.
+ */
+
+static void
+Dummy(void *arg)
+{
+    // never runs
+    FAILED(1,0);
+}
+
+void
+startup(int argc, char **argv)
+{
+    int cid, cid2;
+    int rc, used;
+    P1StackPoolStats stats;
+
+    P1ContextInit();
+    rc = P1ContextCreate(Dummy, NULL, USLOSS_MIN_STACK, &cid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1ContextFree(cid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1ContextStackUsage(cid, &used);
+    TEST(rc, P1_SUCCESS);
+    TEST(used, 0);
+    P1StackPoolGetStats(&stats);
+    TEST(stats.misses, 1);
+    TEST(stats.retained, 1);
+
+    // same class, should come from the pool
+    rc = P1ContextCreate(Dummy, NULL, USLOSS_MIN_STACK, &cid);
+    TEST(rc, P1_SUCCESS);
+    P1StackPoolGetStats(&stats);
+    TEST(stats.hits, 1);
+    TEST(stats.retained, 0);
+
+    // different class, should miss
+    rc = P1ContextCreate(Dummy, NULL, 4 * USLOSS_MIN_STACK, &cid2);
+    TEST(rc, P1_SUCCESS);
+    P1StackPoolGetStats(&stats);
+    TEST(stats.misses, 2);
+
+    rc = P1ContextFree(cid2);
+    TEST(rc, P1_SUCCESS);
+    P1StackPoolGetStats(&stats);
+    TEST(stats.retained, 1);
+
+    // shrinking the cap releases the pooled stack, and later frees bypass the pool
+    P1StackPoolConfig(0);
+    rc = P1ContextFree(cid);
+    TEST(rc, P1_SUCCESS);
+    P1StackPoolGetStats(&stats);
+    TEST(stats.retained, 0);
+    TEST(stats.released, 2);
+
+    rc = P1ContextCreate(Dummy, NULL, USLOSS_MIN_STACK - 1, &cid);
+    TEST(rc, P1_INVALID_STACK);
+    PASSED();
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -5,101 +5,1780 @@ Phase 1b
 #include "phase1Int.h"
 #include "usloss.h"
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
 
+#define CHECKKERNEL() \
+    if ((USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) == 0) USLOSS_IllegalInstruction()
+
+#define HIGHEST_PRIORITY    1
+#define LOWEST_PRIORITY     6           // reserved for the first process
+
+/*
+ * Intrusive doubly-linked lists. A list is a circular chain through a sentinel
+ * head, and the nodes are embedded in the PCB, so inserting, removing, and
+ * splicing whole lists are all O(1) and never allocate.
+ */
+
+typedef struct ListNode {
+    struct ListNode     *prev;
+    struct ListNode     *next;
+} ListNode;
+
+#define LIST_ENTRY(node, type, field) ((type *) ((char *) (node) - offsetof(type, field)))
+
+static inline void
+ListInit(ListNode *head)
+{
+    head->prev = head;
+    head->next = head;
+}
+
+static inline int
+ListEmpty(ListNode *head)
+{
+    return head->next == head;
+}
+
+static inline void
+ListAppend(ListNode *head, ListNode *node)
+{
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+static inline void
+ListRemove(ListNode *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node;
+    node->next = node;
+}
+
+// Moves all of src onto the end of dst, leaving src empty.
+static inline void
+ListSplice(ListNode *dst, ListNode *src)
+{
+    if (!ListEmpty(src)) {
+        src->next->prev = dst->prev;
+        dst->prev->next = src->next;
+        src->prev->next = dst;
+        dst->prev = src->prev;
+        ListInit(src);
+    }
+}
+
 typedef struct PCB {
     int             cid;                // context's ID
-    int             cpuTime;            // process's running time
+    int             cpuTime;            // process's running time (in microseconds)
+    int             inInterrupt;        // TRUE if switched out inside an interrupt handler
+    int             wokenByInterrupt;   // made READY by an interrupt handler, not yet run
+    unsigned int    wakeTime;           // clock reading when that interrupt started
     char            name[P1_MAXNAME];   // process's name
-    int             priority;           // process's priority
+    int             priority;           // process's effective priority; see UpdatePriority
+    int             basePriority;       // priority given to P1_Fork, a ceiling under MLFQ
+    int             schedPriority;      // priority set by the scheduling policy
+    int             inheritedPriority;  // priority inherited from lock waiters, 0 if none
+    int             quantumUsed;        // CPU time used at the current MLFQ level
+    int             sliceTicks;         // clock ticks since it was last dispatched or rotated
+    int             tickets;            // stride scheduling tickets
+    unsigned long long stride;          // STRIDE_ONE / tickets
+    unsigned long long pass;            // stride virtual time, advanced as it runs
+    int             heapIndex;          // index in its ready heap under stride scheduling
+    P1_SchedStats   sched;              // dispatcher counters; see P1_GetSchedStats
     P1_State        state;              // state of the PCB
-    // more fields here
+    int             pid;                // process's slot in processTable; see PidOf
+    int             generation;         // incremented each time the PCB is freed
+    int             parent;             // parent's slot when forked, -1 if none; see ParentOf
+    int             parentGeneration;   // parent's generation when forked
+    int             joinPid;            // child a JOINING process waits for, -1 if any
+    int             status;             // exit status, valid once the process has quit
+    int             lid;                // lock the process is blocked on, -1 if none
+    int             vid;                // condition the process is blocked on, -1 if none
+    int             (*startFunc)(void *); // function the process runs
+    void            *startArg;          // argument to startFunc
+    ListNode        readyLink;          // link in the ready queue for its priority
+    ListNode        siblingLink;        // link in its parent's children or quitChildren
+    ListNode        children;           // children that haven't quit
+    ListNode        quitChildren;       // children that have quit, in the order they quit
 } PCB;
 
-static PCB processTable[P1_MAXPROC];   // the process table
+/*
+ * The process table. It grows PROC_CHUNK PCBs at a time, up to procCapacity
+ * entries, and chunks are never moved or freed, so PIDs and PCB pointers stay
+ * valid as it grows.
+ */
+
+#define PROC_CHUNK      P1_BITMAP_BITS
+
+#if P1_MAXPROC_LIMIT > P1_BITMAP_MAX
+#error "P1_MAXPROC_LIMIT is too large for the PCB bitmap"
+#endif
+
+static PCB      *processTable[P1_MAXPROC_LIMIT / PROC_CHUNK];  // the process table
+static int      numProcs = 0;           // # of PCBs in processTable
+static int      procCapacity = P1_MAXPROC; // max # of PCBs processTable can grow to
+static P1Bitmap freePCBs;               // free slots in processTable
+static P1NameIndex procNames;           // slots of processes that aren't FREE, by name
+static P1SchedPolicy policy;            // see P1ProcInitPolicy
+
+static int HeapsReserve(int n);
+
+static inline PCB *
+Proc(int pid)
+{
+    return &processTable[pid / PROC_CHUNK][pid % PROC_CHUNK];
+}
+
+/*
+ * Internally a process is named by its slot in processTable, and the PCB's pid field
+ * is its slot. The PIDs the API hands out add the slot's generation (see
+ * P1PidSlot), and Slot maps them back, so a PID kept after its process was freed is
+ * rejected rather than naming whatever process reuses the slot.
+ */
+
+#define GENERATION_MASK ((1 << (31 - P1_PID_SLOT_BITS)) - 1)
+
+static inline int
+PidOf(int slot)
+{
+    if (slot == -1) {
+        return -1;
+    }
+    return ((Proc(slot)->generation & GENERATION_MASK) << P1_PID_SLOT_BITS) | slot;
+}
+
+// Returns the slot of the process with PID pid, or -1 if there is no such process.
+static inline int
+Slot(int pid)
+{
+    int slot = P1PidSlot(pid);
+
+    if ((pid < 0) || (slot >= numProcs) || (Proc(slot)->state == P1_STATE_FREE) ||
+        (PidOf(slot) != pid)) {
+        return -1;
+    }
+    return slot;
+}
+
+/*
+ * Adds a chunk of free PCBs to the process table, growing the stride scheduling
+ * heaps to match. Returns FALSE if the table is already at its capacity.
+ */
+static int
+GrowProcessTable(void)
+{
+    int     chunk = numProcs / PROC_CHUNK;
+    int     size;
+
+    if (numProcs >= procCapacity) {
+        return FALSE;
+    }
+    if (processTable[chunk] == NULL) {
+        processTable[chunk] = malloc(PROC_CHUNK * sizeof(PCB));
+        if (processTable[chunk] == NULL) {
+            return FALSE;
+        }
+    }
+    // fill out the rest of the chunk, or as much of it as the capacity allows
+    size = (chunk + 1) * PROC_CHUNK;
+    if (size > procCapacity) {
+        size = procCapacity;
+    }
+    if ((policy == P1_SCHED_STRIDE) && !HeapsReserve(size)) {
+        return FALSE;
+    }
+    for (int i = numProcs; i < size; i++) {
+        Proc(i)->pid = i;
+        Proc(i)->generation = 0;
+        Proc(i)->state = P1_STATE_FREE;
+        Proc(i)->cid = -1;
+        Proc(i)->parent = -1;
+        P1BitmapFree(&freePCBs, i);
+    }
+    numProcs = size;
+    return TRUE;
+}
+
+/*
+ * Sets the maximum number of processes. The process table grows on demand up to
+ * this size. It can't be set beyond P1_MAXPROC_LIMIT or below the current size
+ * of the table.
+ */
+int
+P1_SetProcCapacity(int capacity)
+{
+    int result = P1_SUCCESS;
+    int enabled = P1DisableInterrupts();
+
+    if ((capacity > P1_MAXPROC_LIMIT) || (capacity < numProcs) || (capacity < 1)) {
+        result = P1_TOO_MANY_PROCESSES;
+    } else {
+        procCapacity = capacity;
+    }
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+static int currentPid = -1;             // PID of the running process
+static int firstPid = -1;               // PID of the first process, which inherits orphans
+
+/*
+ * Returns the PID of a process's parent. When a process quits its children are
+ * spliced onto the first process's lists without touching each child, so a child
+ * whose recorded parent has quit, or whose parent's PCB has since been reused,
+ * belongs to the first process.
+ */
+static int
+ParentOf(PCB *pcb)
+{
+    PCB     *parent;
+
+    if (pcb->parent == -1) {
+        return -1;
+    }
+    parent = Proc(pcb->parent);
+    if ((parent->generation != pcb->parentGeneration) || (parent->state == P1_STATE_QUIT)) {
+        return firstPid;
+    }
+    return pcb->parent;
+}
+
+/*
+ * CPU accounting. The USLOSS clock is read at every context switch, interrupt handler
+ * entry and exit, and idle transition, and the time since the previous reading is
+ * charged to whichever was running: the sentinel waiting for an interrupt (idle), an
+ * interrupt handler, or the current process. A handler can dispatch another process,
+ * so inInterrupt is saved in the PCB across context switches.
+ */
+
+static unsigned int lastCharge;         // clock reading at the last charge
+static int          inInterrupt;        // TRUE while an interrupt handler is running
+static int          idle;               // TRUE while the sentinel waits for an interrupt
+static P1CpuStats   cpuStats;
+static unsigned int interruptStart;     // clock reading when the current handler started
+static int          needResched;        // a handler woke a process that outranks the current one
+static int          wakeLatency[P1_LATENCY_BUCKETS];
+static P1_SchedStats schedStats;        // kernel-wide dispatcher counters
+
+static unsigned int
+ClockNow(void)
+{
+    int now;
+    int rc = USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &now);
+    assert(rc == USLOSS_DEV_OK);
+    return now;
+}
+
+static void
+Charge(void)
+{
+    unsigned int now = ClockNow();
+    unsigned int delta = now - lastCharge;
+
+    if (idle) {
+        cpuStats.idle += delta;
+    } else if (inInterrupt) {
+        cpuStats.interrupt += delta;
+    } else if (currentPid != -1) {
+        Proc(currentPid)->cpuTime += delta;
+        Proc(currentPid)->quantumUsed += delta;
+        Proc(currentPid)->pass += delta * Proc(currentPid)->stride;
+    }
+    lastCharge = now;
+}
+
+/*
+ * Called on entry to and exit from a device interrupt handler, so the time spent
+ * handling the interrupt isn't charged to the process it interrupted.
+ */
+void
+P1InterruptEnter(void)
+{
+    Charge();
+    idle = FALSE;
+    inInterrupt = TRUE;
+    interruptStart = lastCharge;
+}
+
+void
+P1InterruptExit(void)
+{
+    Charge();
+    inInterrupt = FALSE;
+    // switch to a process the handler woke rather than waiting for the next rotation
+    if (needResched) {
+        P1Dispatch(FALSE);
+    }
+}
+
+/*
+ * The sentinel calls P1Idle(TRUE) before USLOSS_WaitInt and P1Idle(FALSE) after it.
+ * Idle time ends when the next interrupt handler is entered.
+ */
+void
+P1Idle(int waiting)
+{
+    int enabled = P1DisableInterrupts();
+
+    Charge();
+    idle = waiting;
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+}
+
+/*
+ * Wake-up latency, from the start of the interrupt handler that made a process READY
+ * to when the process runs. Bucket 0 counts latencies under 1 microsecond and bucket
+ * i > 0 those in [2^(i-1), 2^i), except that the last bucket also counts all longer
+ * ones.
+ */
+static void
+RecordWakeLatency(PCB *pcb)
+{
+    unsigned int latency = lastCharge - pcb->wakeTime;
+    int bucket = (latency == 0) ? 0 : 32 - __builtin_clz(latency);
+
+    if (bucket >= P1_LATENCY_BUCKETS) {
+        bucket = P1_LATENCY_BUCKETS - 1;
+    }
+    wakeLatency[bucket]++;
+    pcb->wokenByInterrupt = FALSE;
+}
+
+void
+P1GetWakeLatency(int *buckets)
+{
+    int enabled = P1DisableInterrupts();
+
+    memcpy(buckets, wakeLatency, sizeof(wakeLatency));
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+}
+
+void
+P1GetCpuStats(P1CpuStats *stats)
+{
+    int enabled = P1DisableInterrupts();
+
+    Charge();
+    *stats = cpuStats;
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+}
+
+/*
+ * Scheduler trace. With -DP1_TRACE every context switch, P1SetState, fork, and quit
+ * is recorded in a ring buffer that keeps the last P1_TRACE_SIZE events. Events are
+ * only recorded with interrupts disabled, so recording is safe from interrupt
+ * handlers. Without P1_TRACE, TRACE records nothing.
+ */
+
+#ifdef P1_TRACE
+
+static P1TraceEvent traceBuf[P1_TRACE_SIZE];
+static unsigned int traceNext;          // total events recorded
+
+static inline void
+Trace(int type, int arg, int pid, int other)
+{
+    P1TraceEvent *event = &traceBuf[traceNext++ & (P1_TRACE_SIZE - 1)];
+
+    event->time = ClockNow();
+    event->type = type;
+    event->arg = arg;
+    event->pid = pid;
+    event->other = other;
+}
+
+#define TRACE(type, arg, pid, other) Trace(type, arg, pid, other)
+
+#else
+
+#define TRACE(type, arg, pid, other) ((void) (arg))
+
+#endif
+
+/*
+ * Copies the most recent max trace events into events, oldest first, and returns
+ * the number copied. Returns 0 if tracing isn't compiled in.
+ */
+int
+P1TraceSnapshot(P1TraceEvent *events, int max)
+{
+    int count = 0;
+#ifdef P1_TRACE
+    int enabled = P1DisableInterrupts();
+    unsigned int first;
+
+    count = (traceNext < P1_TRACE_SIZE) ? traceNext : P1_TRACE_SIZE;
+    if (count > max) {
+        count = max;
+    }
+    first = traceNext - count;
+    for (int i = 0; i < count; i++) {
+        events[i] = traceBuf[(first + i) & (P1_TRACE_SIZE - 1)];
+    }
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+#endif
+    return count;
+}
+
+/*
+ * Writes the trace to a file for tools/p1trace. Returns the number of events written,
+ * or -1 if the file couldn't be written.
+ */
+int
+P1TraceDump(char *path)
+{
+    static P1TraceEvent events[P1_TRACE_SIZE];
+    P1TraceHeader header;
+    FILE *f;
+    int result;
+
+    header.magic = P1_TRACE_MAGIC;
+    header.version = P1_TRACE_VERSION;
+    header.count = P1TraceSnapshot(events, P1_TRACE_SIZE);
+    header.dropped = 0;
+#ifdef P1_TRACE
+    header.dropped = traceNext - header.count;
+#endif
+    f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    result = header.count;
+    if ((fwrite(&header, sizeof(header), 1, f) != 1) ||
+        (fwrite(events, sizeof(events[0]), header.count, f) != header.count)) {
+        result = -1;
+    }
+    if (fclose(f) != 0) {
+        result = -1;
+    }
+    return result;
+}
+
+/*
+ * Stride scheduling heaps. Under P1_SCHED_STRIDE the READY processes at each priority
+ * are kept in a min-heap on pass instead of a FIFO. A process's pass advances by its
+ * stride for each microsecond it runs, so the one with the smallest pass is the one
+ * furthest behind its share. levelPass is the pass of the last process dispatched at
+ * each priority; a process that becomes ready has its pass raised to at least that,
+ * so it can't claim the time it spent blocked. The heaps are sized with the process
+ * table, so pushing never fails.
+ */
+
+#define STRIDE_ONE      (1 << 20)
+
+typedef struct StrideHeap {
+    int                 *pids;
+    int                 size;
+    unsigned long long  levelPass;
+} StrideHeap;
+
+static StrideHeap   heaps[LOWEST_PRIORITY + 1];
+
+static int
+HeapLess(int a, int b)
+{
+    return Proc(a)->pass < Proc(b)->pass;
+}
+
+static void
+HeapSet(StrideHeap *heap, int i, int pid)
+{
+    heap->pids[i] = pid;
+    Proc(pid)->heapIndex = i;
+}
+
+static void
+HeapSiftUp(StrideHeap *heap, int i)
+{
+    int pid = heap->pids[i];
+
+    while ((i > 0) && HeapLess(pid, heap->pids[(i - 1) / 2])) {
+        HeapSet(heap, i, heap->pids[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    HeapSet(heap, i, pid);
+}
+
+static void
+HeapSiftDown(StrideHeap *heap, int i)
+{
+    int pid = heap->pids[i];
+    int child;
+
+    while ((child = 2 * i + 1) < heap->size) {
+        if ((child + 1 < heap->size) && HeapLess(heap->pids[child + 1], heap->pids[child])) {
+            child++;
+        }
+        if (!HeapLess(heap->pids[child], pid)) {
+            break;
+        }
+        HeapSet(heap, i, heap->pids[child]);
+        i = child;
+    }
+    HeapSet(heap, i, pid);
+}
+
+static void
+HeapPush(StrideHeap *heap, int pid)
+{
+    if (Proc(pid)->pass < heap->levelPass) {
+        Proc(pid)->pass = heap->levelPass;
+    }
+    heap->pids[heap->size++] = pid;
+    HeapSiftUp(heap, heap->size - 1);
+}
+
+static void
+HeapRemove(StrideHeap *heap, int pid)
+{
+    int i = Proc(pid)->heapIndex;
+    int last = heap->pids[--heap->size];
+
+    if (i < heap->size) {
+        HeapSet(heap, i, last);
+        HeapSiftUp(heap, i);
+        HeapSiftDown(heap, Proc(last)->heapIndex);
+    }
+}
+
+// Grows the heaps to hold n processes each.
+static int
+HeapsReserve(int n)
+{
+    for (int i = HIGHEST_PRIORITY; i <= LOWEST_PRIORITY; i++) {
+        int *pids = realloc(heaps[i].pids, n * sizeof(int));
+        if (pids == NULL) {
+            return FALSE;
+        }
+        heaps[i].pids = pids;
+    }
+    return TRUE;
+}
+
+/*
+ * Ready queues. There is a FIFO of READY processes for each priority, and bit p of
+ * readyLevels is set if the queue for priority p is non-empty, so the dispatcher
+ * finds the highest-priority ready process with one find-first-set. The running
+ * process is not on a ready queue.
+ */
+
+static ListNode     readyQueues[LOWEST_PRIORITY + 1];
+static int          readyCount[LOWEST_PRIORITY + 1];
+static unsigned int readyLevels;
+
+static void
+ReadyEnqueue(int pid)
+{
+    int     priority = Proc(pid)->priority;
+
+    if (policy == P1_SCHED_STRIDE) {
+        HeapPush(&heaps[priority], pid);
+    } else {
+        ListAppend(&readyQueues[priority], &Proc(pid)->readyLink);
+    }
+    readyCount[priority]++;
+    readyLevels |= 1 << priority;
+}
+
+static void
+ReadyRemove(int pid)
+{
+    int     priority = Proc(pid)->priority;
+
+    if (policy == P1_SCHED_STRIDE) {
+        HeapRemove(&heaps[priority], pid);
+    } else {
+        ListRemove(&Proc(pid)->readyLink);
+    }
+    if (--readyCount[priority] == 0) {
+        readyLevels &= ~(1 << priority);
+    }
+}
+
+// Returns the next process to run at the priority, without removing it.
+static int
+ReadyPeek(int priority)
+{
+    if (policy == P1_SCHED_STRIDE) {
+        return heaps[priority].pids[0];
+    }
+    return LIST_ENTRY(readyQueues[priority].next, PCB, readyLink)->pid;
+}
+
+static int
+ReadyDequeue(int priority)
+{
+    int     pid = ReadyPeek(priority);
+
+    ReadyRemove(pid);
+    if (policy == P1_SCHED_STRIDE) {
+        heaps[priority].levelPass = Proc(pid)->pass;
+    }
+    return pid;
+}
+
+/*
+ * Recomputes a process's effective priority, the higher of its scheduled priority
+ * and the priority it inherits from processes waiting for locks it holds, and moves
+ * it to the new ready queue if it is READY.
+ */
+static void
+UpdatePriority(int pid)
+{
+    PCB     *pcb = Proc(pid);
+    int     priority = pcb->schedPriority;
+
+    if ((pcb->inheritedPriority != 0) && (pcb->inheritedPriority < priority)) {
+        priority = pcb->inheritedPriority;
+    }
+    if (priority == pcb->priority) {
+        return;
+    }
+    if (pcb->state == P1_STATE_READY) {
+        ReadyRemove(pid);
+        pcb->priority = priority;
+        ReadyEnqueue(pid);
+    } else {
+        pcb->priority = priority;
+    }
+}
+
+/*
+ * Priority inheritance, used by the locks in phase 1c. A lock holder inherits the
+ * priority of the highest-priority process waiting for it; a priority of 0 removes
+ * the inherited priority. Phase 1c follows chains of locks itself.
+ */
+int
+P1SetInheritedPriority(int pid, int priority)
+{
+    int result = P1_SUCCESS;
+    int enabled;
+    int slot;
+
+    if ((priority < 0) || (priority > LOWEST_PRIORITY)) {
+        return P1_INVALID_PRIORITY;
+    }
+    enabled = P1DisableInterrupts();
+    slot = Slot(pid);
+    if (slot == -1) {
+        result = P1_INVALID_PID;
+        goto done;
+    }
+    Proc(slot)->inheritedPriority = priority;
+    UpdatePriority(slot);
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+// Returns a process's effective priority, or P1_INVALID_PID.
+int
+P1GetPriority(int pid)
+{
+    int slot = Slot(pid);
+
+    if (slot == -1) {
+        return P1_INVALID_PID;
+    }
+    return Proc(slot)->priority;
+}
+
+/*
+ * Time quanta. The clock interrupt handler calls P1Tick on every tick, and when the
+ * running process has used its priority's quantum it is rotated to the back of its
+ * level. If no other process is ready at its level the rotation would be pointless,
+ * so it is skipped and counted in rotationsAvoided. In adaptive mode the quantum
+ * shrinks when more than two processes share the level: for n processes it is 2/n
+ * of the base, so a full round of the level takes about two base quanta however
+ * many there are.
+ */
+
+static int  quanta[LOWEST_PRIORITY + 1];    // base quantum of each priority, in ticks
+static int  adaptiveQuanta;
+static int  rotationsAvoided;
+
+static int
+Quantum(int priority)
+{
+    int     quantum = quanta[priority];
+    int     sharing = readyCount[priority] + 1;  // including the running process
+
+    if (adaptiveQuanta && (sharing > 2)) {
+        quantum = (2 * quantum) / sharing;
+        if (quantum < 1) {
+            quantum = 1;
+        }
+    }
+    return quantum;
+}
+
+/*
+ * Sets the quantum of a priority in clock ticks. The default is P1_DEFAULT_QUANTUM.
+ * Returns P1_INVALID_QUANTUM if ticks is less than 1.
+ */
+int
+P1SetQuantum(int priority, int ticks)
+{
+    if ((priority < HIGHEST_PRIORITY) || (priority > LOWEST_PRIORITY)) {
+        return P1_INVALID_PRIORITY;
+    }
+    if (ticks < 1) {
+        return P1_INVALID_QUANTUM;
+    }
+    quanta[priority] = ticks;
+    return P1_SUCCESS;
+}
+
+void
+P1SetAdaptiveQuantum(int enable)
+{
+    adaptiveQuanta = enable;
+}
+
+int
+P1GetRotationsAvoided(void)
+{
+    return rotationsAvoided;
+}
+
+/*
+ * Called by the clock interrupt handler on every tick.
+ */
+void
+P1Tick(void)
+{
+    int     enabled = P1DisableInterrupts();
+    PCB     *current = (currentPid == -1) ? NULL : Proc(currentPid);
+    int     ready = 0;
+
+    // sample the ready queue length
+    for (int i = HIGHEST_PRIORITY; i <= LOWEST_PRIORITY; i++) {
+        ready += readyCount[i];
+    }
+    if ((schedStats.readySamples == 0) || (ready < schedStats.readyMin)) {
+        schedStats.readyMin = ready;
+    }
+    if (ready > schedStats.readyMax) {
+        schedStats.readyMax = ready;
+    }
+    schedStats.readyTotal += ready;
+    schedStats.readySamples++;
+    if ((current == NULL) || (current->state != P1_STATE_RUNNING)) {
+        goto done;
+    }
+    if (++current->sliceTicks < Quantum(current->priority)) {
+        goto done;
+    }
+    current->sliceTicks = 0;
+    if (readyCount[current->priority] == 0) {
+        rotationsAvoided++;
+    } else {
+        P1Dispatch(TRUE);
+    }
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+}
+
+/*
+ * Scheduling policy, chosen by P1ProcInitPolicy. P1_SCHED_PRIORITY is fixed priority
+ * with round-robin within a priority. P1_SCHED_MLFQ is a multi-level feedback queue
+ * over the same ready queues: a process that uses its level's quantum of CPU
+ * drops a level, one that blocks rises a level, and every MLFQ_BOOST all processes
+ * return to their base priority. A process never rises above its base priority and
+ * only the first process runs at LOWEST_PRIORITY.
+ */
+
+#define MLFQ_BOOST      1000000
+
+static unsigned int     lastBoost;      // clock reading at the last MLFQ boost
+
+static void
+MlfqBoost(void)
+{
+    for (int i = 0; i < numProcs; i++) {
+        PCB *pcb = Proc(i);
+        if (pcb->state != P1_STATE_FREE) {
+            pcb->quantumUsed = 0;
+            pcb->schedPriority = pcb->basePriority;
+            UpdatePriority(i);
+        }
+    }
+    lastBoost = lastCharge;
+}
+
+// Demotes the current process if it has used up its quantum. Call after Charge.
+static void
+MlfqDemote(PCB *current)
+{
+    if (current->quantumUsed >= quanta[current->schedPriority] * USLOSS_CLOCK_MS * 1000) {
+        current->quantumUsed = 0;
+        if (current->schedPriority < LOWEST_PRIORITY - 1) {
+            current->schedPriority++;
+            UpdatePriority(current->pid);
+        }
+    }
+}
+
+// Promotes a process that is blocking.
+static void
+MlfqPromote(PCB *pcb)
+{
+    pcb->quantumUsed = 0;
+    if (pcb->schedPriority > pcb->basePriority) {
+        pcb->schedPriority--;
+        UpdatePriority(pcb->pid);
+    }
+}
+
+/*
+ * Changes a process's state, keeping the ready queues in sync.
+ */
+static void
+ChangeState(int pid, P1_State state)
+{
+    PCB     *pcb = Proc(pid);
+
+    if ((pcb->state == P1_STATE_READY) && (state != P1_STATE_READY)) {
+        ReadyRemove(pid);
+    } else if ((pcb->state != P1_STATE_READY) && (state == P1_STATE_READY)) {
+        ReadyEnqueue(pid);
+    }
+    pcb->state = state;
+}
+
+/*
+ * Stack auto-sizing. When a process is cleaned up its stack high-water mark is
+ * recorded against the function it ran. If auto-sizing is enabled, later forks of
+ * the same function get a stack sized from that peak (plus AUTO_STACK_SLACK) rather
+ * than the size requested, but never more than requested or less than USLOSS_MIN_STACK.
+ */
+
+#define STACK_PROFILES      64          // must be a power of 2
+#define AUTO_STACK_SLACK(x) ((x) + (x) / 2)
+
+typedef struct StackProfile {
+    int     (*func)(void *);            // function, NULL if the entry is unused
+    int     peak;                       // deepest stack usage seen
+} StackProfile;
+
+static StackProfile stackProfiles[STACK_PROFILES];
+static int          stackAutoSize = FALSE;
+
+/*
+ * Returns the profile for func, creating it if create is TRUE. Returns NULL if
+ * there is no profile and one can't be created.
+ */
+static StackProfile *
+StackProfileFind(int (*func)(void *), int create)
+{
+    int     start = ((unsigned long) func >> 4) & (STACK_PROFILES - 1);
+    int     i = start;
+
+    do {
+        if (stackProfiles[i].func == func) {
+            return &stackProfiles[i];
+        }
+        if (stackProfiles[i].func == NULL) {
+            if (!create) {
+                return NULL;
+            }
+            stackProfiles[i].func = func;
+            stackProfiles[i].peak = 0;
+            return &stackProfiles[i];
+        }
+        i = (i + 1) & (STACK_PROFILES - 1);
+    } while (i != start);
+    return NULL;
+}
+
+void
+P1StackAutoSize(int enable)
+{
+    stackAutoSize = enable;
+    // the stack profiles come from measuring stacks when processes are freed
+    P1ContextMeasureStacks(enable);
+}
+
+/*
+ * Frees the PCB of a process that has quit, and its context, recording how much
+ * stack it used.
+ */
+static void
+FreeProcess(int pid)
+{
+    PCB             *pcb = Proc(pid);
+    StackProfile    *profile;
+    int             used;
+    int             rc;
+
+    rc = P1ContextFree(pcb->cid);
+    assert(rc == P1_SUCCESS);
+    rc = P1ContextStackUsage(pcb->cid, &used);
+    assert(rc == P1_SUCCESS);
+    profile = StackProfileFind(pcb->startFunc, TRUE);
+    if ((profile != NULL) && (used > profile->peak)) {
+        profile->peak = used;
+    }
+    ListRemove(&pcb->siblingLink);
+    P1NameIndexRemove(&procNames, pcb->name);
+    pcb->state = P1_STATE_FREE;
+    pcb->generation++;
+    P1BitmapFree(&freePCBs, pid);
+}
+
+/*
+ * Helper function that runs the process's function with interrupts enabled and
+ * quits with its return value.
+ */
+static void
+launch(void *arg)
+{
+    int pid = (int) arg;
+    int rc;
+
+    // a new process isn't inside its creator's interrupt handler
+    inInterrupt = FALSE;
+    P1EnableInterrupts();
+    rc = Proc(pid)->startFunc(Proc(pid)->startArg);
+    P1_Quit(rc);
+}
 
 void P1ProcInit(void)
+{
+    P1ProcInitPolicy(P1_SCHED_PRIORITY);
+}
+
+void P1ProcInitPolicy(P1SchedPolicy schedPolicy)
 {
     P1ContextInit();
-    for (int i = 0; i < P1_MAXPROC; i++) {
-        processTable[i].state = P1_STATE_FREE;
-        // initialize the rest of the PCB
-    }
+    policy = schedPolicy;
+    // PCBs are initialized as the table grows
+    P1BitmapInit(&freePCBs, 0);
+    P1NameIndexInit(&procNames);
+    numProcs = 0;
     // initialize everything else
+    for (int i = HIGHEST_PRIORITY; i <= LOWEST_PRIORITY; i++) {
+        ListInit(&readyQueues[i]);
+        heaps[i].size = 0;
+        heaps[i].levelPass = 0;
+        readyCount[i] = 0;
+        quanta[i] = P1_DEFAULT_QUANTUM;
+    }
+    adaptiveQuanta = FALSE;
+    rotationsAvoided = 0;
+    readyLevels = 0;
+    currentPid = -1;
+    firstPid = -1;
+    lastCharge = ClockNow();
+    needResched = FALSE;
+    memset(wakeLatency, 0, sizeof(wakeLatency));
+    memset(&schedStats, 0, sizeof(schedStats));
+    lastBoost = lastCharge;
+    inInterrupt = FALSE;
+    idle = FALSE;
+    memset(&cpuStats, 0, sizeof(cpuStats));
+}
 
+int P1_GetPid(void)
+{
+    return PidOf(currentPid);
 }
 
-int P1_GetPid(void) 
+int P1_Fork(char *name, int (*func)(void*), void *arg, int stacksize, int priority, int *pid )
 {
-    return 0;
+    return P1_ForkTickets(name, func, arg, stacksize, priority, P1_DEFAULT_TICKETS, pid);
 }
 
-int P1_Fork(char *name, int (*func)(void*), void *arg, int stacksize, int priority, int *pid ) 
+/*
+ * Creates a READY process without dispatching. Interrupts must be disabled.
+ */
+static int
+ForkProcess(char *name, int (*func)(void*), void *arg, int stacksize, int priority,
+            int tickets, int *pid)
 {
-    int result = P1_SUCCESS;
+    int             result = P1_SUCCESS;
+    int             i;
+    int             cid;
+    PCB             *pcb;
+    StackProfile    *profile;
 
-    // check for kernel mode
-    // disable interrupts
     // check all parameters
+    if (currentPid == -1) {
+        // the first process must run at the lowest priority
+        if (priority != LOWEST_PRIORITY) {
+            result = P1_INVALID_PRIORITY;
+            goto done;
+        }
+    } else if ((priority < HIGHEST_PRIORITY) || (priority >= LOWEST_PRIORITY)) {
+        result = P1_INVALID_PRIORITY;
+        goto done;
+    }
+    if ((tickets < 1) || (tickets > P1_MAX_TICKETS)) {
+        result = P1_INVALID_TICKETS;
+        goto done;
+    }
+    if (stacksize < USLOSS_MIN_STACK) {
+        result = P1_INVALID_STACK;
+        goto done;
+    }
+    if (name == NULL) {
+        result = P1_NAME_IS_NULL;
+        goto done;
+    }
+    if (strlen(name) >= P1_MAXNAME) {
+        result = P1_NAME_TOO_LONG;
+        goto done;
+    }
+    if (P1NameIndexFind(&procNames, name) != -1) {
+        result = P1_DUPLICATE_NAME;
+        goto done;
+    }
+    i = P1BitmapAlloc(&freePCBs);
+    if ((i == -1) && GrowProcessTable()) {
+        i = P1BitmapAlloc(&freePCBs);
+    }
+    if (i == -1) {
+        result = P1_TOO_MANY_PROCESSES;
+        goto done;
+    }
+    if (stackAutoSize) {
+        profile = StackProfileFind(func, FALSE);
+        if ((profile != NULL) && (profile->peak > 0) &&
+            (AUTO_STACK_SLACK(profile->peak) < stacksize)) {
+            stacksize = AUTO_STACK_SLACK(profile->peak);
+            if (stacksize < USLOSS_MIN_STACK) {
+                stacksize = USLOSS_MIN_STACK;
+            }
+        }
+    }
     // create a context using P1ContextCreate
+    result = P1ContextCreate(launch, (void *) i, stacksize, &cid);
+    if (result != P1_SUCCESS) {
+        P1BitmapFree(&freePCBs, i);
+        goto done;
+    }
     // allocate and initialize PCB
-    // if this is the first process or this process's priority is higher than the 
+    pcb = Proc(i);
+    pcb->cid = cid;
+    pcb->cpuTime = 0;
+    pcb->inInterrupt = FALSE;
+    pcb->wokenByInterrupt = FALSE;
+    memset(&pcb->sched, 0, sizeof(pcb->sched));
+    strcpy(pcb->name, name);
+    P1NameIndexInsert(&procNames, pcb->name, i);
+    pcb->priority = priority;
+    pcb->basePriority = priority;
+    pcb->schedPriority = priority;
+    pcb->inheritedPriority = 0;
+    pcb->quantumUsed = 0;
+    pcb->sliceTicks = 0;
+    pcb->tickets = tickets;
+    pcb->stride = STRIDE_ONE / tickets;
+    pcb->pass = 0;
+    pcb->parent = currentPid;
+    ListInit(&pcb->children);
+    ListInit(&pcb->quitChildren);
+    if (currentPid == -1) {
+        firstPid = i;
+        ListInit(&pcb->siblingLink);
+    } else {
+        pcb->parentGeneration = Proc(currentPid)->generation;
+        ListAppend(&Proc(currentPid)->children, &pcb->siblingLink);
+    }
+    pcb->status = 0;
+    pcb->lid = -1;
+    pcb->vid = -1;
+    pcb->joinPid = -1;
+    pcb->startFunc = func;
+    pcb->startArg = arg;
+    ChangeState(i, P1_STATE_READY);
+    TRACE(P1_TRACE_FORK, priority, PidOf(currentPid), PidOf(i));
+    *pid = PidOf(i);
+done:
+    return result;
+}
+
+/*
+ * P1_Fork with the process's stride scheduling tickets. Tickets only matter under
+ * P1_SCHED_STRIDE. Returns P1_INVALID_TICKETS if tickets is out of range.
+ */
+int P1_ForkTickets(char *name, int (*func)(void*), void *arg, int stacksize, int priority,
+                   int tickets, int *pid)
+{
+    int             result;
+    int             enabled;
+
+    // check for kernel mode
+    CHECKKERNEL();
+    // disable interrupts
+    enabled = P1DisableInterrupts();
+    result = ForkProcess(name, func, arg, stacksize, priority, tickets, pid);
+    if (result != P1_SUCCESS) {
+        goto done;
+    }
+    // if this is the first process or this process's priority is higher than the
     //    currently running process call P1Dispatch(FALSE)
+    if ((currentPid == -1) || (priority < Proc(currentPid)->priority)) {
+        P1Dispatch(FALSE);
+    }
+done:
     // re-enable interrupts if they were previously enabled
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+/*
+ * Forks count processes, described by specs, in one critical section and returns
+ * their PIDs in pids. None of them runs until all have been created, and the caller
+ * is preempted at most once. If any fork fails the processes already created are
+ * freed and its error is returned, so either all are created or none are. A batch
+ * can't create the first process.
+ */
+int
+P1_ForkMany(P1_ForkSpec *specs, int count, int *pids)
+{
+    int             result = P1_SUCCESS;
+    int             enabled;
+    int             i;
+    int             highest = LOWEST_PRIORITY;
+    P1_ForkSpec     *spec;
+
+    CHECKKERNEL();
+    enabled = P1DisableInterrupts();
+    if (currentPid == -1) {
+        result = P1_INVALID_PRIORITY;
+        goto done;
+    }
+    for (i = 0; i < count; i++) {
+        spec = &specs[i];
+        result = ForkProcess(spec->name, spec->func, spec->arg, spec->stackSize,
+                             spec->priority, P1_DEFAULT_TICKETS, &pids[i]);
+        if (result != P1_SUCCESS) {
+            // none of them has run, so they can be freed as if they had quit
+            while (--i >= 0) {
+                ChangeState(P1PidSlot(pids[i]), P1_STATE_QUIT);
+                FreeProcess(P1PidSlot(pids[i]));
+            }
+            goto done;
+        }
+        if (spec->priority < highest) {
+            highest = spec->priority;
+        }
+    }
+    if (highest < Proc(currentPid)->priority) {
+        P1Dispatch(FALSE);
+    }
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
     return result;
 }
 
-void 
-P1_Quit(int status) 
+static void (*quitHook)(int pid);   // see P1SetQuitHook
+
+/*
+ * Sets a function that P1_Quit calls with the PID of the quitting process before it
+ * quits, so phase 1c can release the locks the process still holds. NULL for none.
+ */
+void
+P1SetQuitHook(void (*hook)(int pid))
 {
+    quitHook = hook;
+}
+
+void
+P1_Quit(int status)
+{
+    PCB     *pcb;
+    PCB     *first;
+    int     parent;
+    int     enabled;
+
     // check for kernel mode
+    CHECKKERNEL();
     // disable interrupts
+    enabled = P1DisableInterrupts();
     // remove from ready queue, set status to P1_STATE_QUIT
+    if (quitHook != NULL) {
+        quitHook(PidOf(currentPid));
+    }
+    pcb = Proc(currentPid);
+    parent = ParentOf(pcb);
+    ChangeState(currentPid, P1_STATE_QUIT);
+    pcb->status = status;
+    TRACE(P1_TRACE_QUIT, 0, PidOf(currentPid), status);
     // if first process verify it doesn't have children, otherwise give children to first process
+    if (currentPid == firstPid) {
+        if (!ListEmpty(&pcb->children) || !ListEmpty(&pcb->quitChildren)) {
+            USLOSS_Console("First process quitting with children, halting.\n");
+            USLOSS_Halt(1);
+        }
+    } else {
+        first = Proc(firstPid);
+        ListSplice(&first->children, &pcb->children);
+        ListSplice(&first->quitChildren, &pcb->quitChildren);
+    }
     // add ourself to list of our parent's children that have quit
     // if parent is in state P1_STATE_JOINING set its state to P1_STATE_READY
+    if (parent != -1) {
+        ListRemove(&pcb->siblingLink);
+        ListAppend(&Proc(parent)->quitChildren, &pcb->siblingLink);
+        if ((Proc(parent)->state == P1_STATE_JOINING) &&
+            ((Proc(parent)->joinPid == -1) || (Proc(parent)->joinPid == currentPid))) {
+            ChangeState(parent, P1_STATE_READY);
+        }
+    }
     P1Dispatch(FALSE);
     // should never get here
     assert(0);
+    if (enabled) {
+        P1EnableInterrupts();
+    }
 }
 
 
-int 
-P1GetChildStatus(int *cpid, int *status) 
+/*
+ * Reaps the child at the head of the quit-children FIFO, which must be non-empty.
+ */
+static void
+ReapChild(PCB *pcb, int *cpid, int *status)
+{
+    PCB *child = LIST_ENTRY(pcb->quitChildren.next, PCB, siblingLink);
+
+    *cpid = PidOf(child->pid);
+    *status = child->status;
+    FreeProcess(child->pid);
+}
+
+int
+P1GetChildStatus(int *cpid, int *status)
+{
+    int result = P1_SUCCESS;
+    int enabled = P1DisableInterrupts();
+    PCB *pcb = Proc(currentPid);
+
+    if (!ListEmpty(&pcb->quitChildren)) {
+        ReapChild(pcb, cpid, status);
+    } else if (!ListEmpty(&pcb->children)) {
+        result = P1_NO_QUIT;
+    } else {
+        result = P1_NO_CHILDREN;
+    }
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+// Returns the slot of child cpid of the current process, quit or not, or -1 if it
+// isn't a child.
+static int
+ChildSlot(int cpid)
+{
+    int slot = Slot(cpid);
+
+    if ((slot == -1) || (ParentOf(Proc(slot)) != currentPid)) {
+        return -1;
+    }
+    return slot;
+}
+
+/*
+ * Like P1GetChildStatus but reaps only child cpid. Returns P1_INVALID_PID if cpid
+ * isn't a child of the current process and P1_NO_QUIT if it hasn't quit.
+ */
+int
+P1GetChildStatusPid(int cpid, int *status)
+{
+    int result = P1_SUCCESS;
+    int enabled = P1DisableInterrupts();
+    int slot = ChildSlot(cpid);
+
+    if (slot == -1) {
+        result = P1_INVALID_PID;
+    } else if (Proc(slot)->state != P1_STATE_QUIT) {
+        result = P1_NO_QUIT;
+    } else {
+        *status = Proc(slot)->status;
+        FreeProcess(slot);
+    }
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+/*
+ * Puts the current process in the JOINING state waiting for child cpid only, so
+ * other children quitting don't wake it. Returns P1_CHILD_QUIT if cpid has already
+ * quit and P1_INVALID_PID if it isn't a child of the current process.
+ */
+int
+P1SetJoiningPid(int cpid)
+{
+    int result = P1_SUCCESS;
+    int enabled = P1DisableInterrupts();
+    int slot = ChildSlot(cpid);
+
+    if (slot == -1) {
+        result = P1_INVALID_PID;
+    } else if (Proc(slot)->state == P1_STATE_QUIT) {
+        result = P1_CHILD_QUIT;
+    } else {
+        ChangeState(currentPid, P1_STATE_JOINING);
+        Proc(currentPid)->joinPid = slot;
+        Proc(currentPid)->lid = -1;
+        Proc(currentPid)->vid = -1;
+    }
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+/*
+ * Non-blocking bulk form of P1GetChildStatus. Reaps up to max quit children, in the
+ * order they quit, into cpids and statuses and sets *count to the number reaped. If
+ * cpids and statuses are both NULL every quit child is reaped and max is ignored.
+ */
+int
+P1GetChildStatuses(int *cpids, int *statuses, int max, int *count)
+{
+    int result = P1_SUCCESS;
+    int enabled = P1DisableInterrupts();
+    PCB *pcb = Proc(currentPid);
+    int drain = (cpids == NULL) && (statuses == NULL);
+    int cpid, status;
+
+    *count = 0;
+    if (ListEmpty(&pcb->quitChildren)) {
+        result = ListEmpty(&pcb->children) ? P1_NO_CHILDREN : P1_NO_QUIT;
+        goto done;
+    }
+    while (!ListEmpty(&pcb->quitChildren) && (drain || (*count < max))) {
+        ReapChild(pcb, &cpid, &status);
+        if (cpids != NULL) {
+            cpids[*count] = cpid;
+        }
+        if (statuses != NULL) {
+            statuses[*count] = status;
+        }
+        (*count)++;
+    }
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+int
+P1SetState(int pid, P1_State state, int lid, int vid)
+{
+    int result = P1_SUCCESS;
+    int enabled;
+    int slot;
+
+    if ((state != P1_STATE_READY) && (state != P1_STATE_JOINING) &&
+        (state != P1_STATE_BLOCKED) && (state != P1_STATE_QUIT)) {
+        return P1_INVALID_STATE;
+    }
+    enabled = P1DisableInterrupts();
+    slot = Slot(pid);
+    if (slot == -1) {
+        result = P1_INVALID_PID;
+        goto done;
+    }
+    // from here on the process is named by its slot
+    pid = slot;
+    if ((state == P1_STATE_JOINING) && !ListEmpty(&Proc(pid)->quitChildren)) {
+        result = P1_CHILD_QUIT;
+        goto done;
+    }
+    TRACE(P1_TRACE_STATE, state, PidOf(pid), Proc(pid)->state);
+    ChangeState(pid, state);
+    if ((policy == P1_SCHED_MLFQ) && (state == P1_STATE_BLOCKED)) {
+        MlfqPromote(Proc(pid));
+    }
+    Proc(pid)->joinPid = -1;
+    if ((state == P1_STATE_READY) && inInterrupt) {
+        // P1InterruptExit switches to it if it outranks the interrupted process
+        Proc(pid)->wokenByInterrupt = TRUE;
+        Proc(pid)->wakeTime = interruptStart;
+        if ((currentPid == -1) || (Proc(pid)->priority < Proc(currentPid)->priority)) {
+            needResched = TRUE;
+        }
+    }
+    if (state == P1_STATE_BLOCKED) {
+        Proc(pid)->lid = lid;
+        Proc(pid)->vid = vid;
+    } else {
+        Proc(pid)->lid = -1;
+        Proc(pid)->vid = -1;
+    }
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+/*
+ * Changes the lock and condition a BLOCKED process is blocked on, without changing
+ * its state. Phase 1c uses it to move a signaled waiter from a condition to its
+ * lock, which must not count as blocking again.
+ */
+int
+P1SetBlockedOn(int pid, int lid, int vid)
 {
     int result = P1_SUCCESS;
-    // do stuff here
+    int enabled;
+    int slot;
+
+    enabled = P1DisableInterrupts();
+    slot = Slot(pid);
+    if (slot == -1) {
+        result = P1_INVALID_PID;
+        goto done;
+    }
+    if (Proc(slot)->state != P1_STATE_BLOCKED) {
+        result = P1_INVALID_STATE;
+        goto done;
+    }
+    Proc(slot)->lid = lid;
+    Proc(slot)->vid = vid;
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
     return result;
 }
 
 int
-P1SetState(int pid, P1_State state, int lid, int vid) 
+P1_SetTickets(int pid, int tickets)
 {
     int result = P1_SUCCESS;
-    // do stuff here
+    int enabled;
+    int slot;
+
+    CHECKKERNEL();
+    if ((tickets < 1) || (tickets > P1_MAX_TICKETS)) {
+        return P1_INVALID_TICKETS;
+    }
+    enabled = P1DisableInterrupts();
+    slot = Slot(pid);
+    if (slot == -1) {
+        result = P1_INVALID_PID;
+        goto done;
+    }
+    // the pass is unchanged, so a READY process doesn't move in its heap
+    Proc(slot)->tickets = tickets;
+    Proc(slot)->stride = STRIDE_ONE / tickets;
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
     return result;
 }
 
+// Charges the time since start to P1Dispatch, for the process that called it.
+static void
+DispatchTime(PCB *current, unsigned int start)
+{
+    unsigned int elapsed = ClockNow() - start;
+
+    schedStats.dispatchTime += elapsed;
+    if (current != NULL) {
+        current->sched.dispatchTime += elapsed;
+    }
+}
+
 void
 P1Dispatch(int rotate)
 {
+    int     enabled = P1DisableInterrupts();
+    int     next;
+    int     priority;
+    PCB     *current = (currentPid == -1) ? NULL : Proc(currentPid);
+    int     reason;
+    int     rc;
+    unsigned int start;
+
+    // interrupt handlers only rotate; other dispatches wait for P1InterruptExit
+    if (inInterrupt && !rotate) {
+        goto done;
+    }
+    needResched = FALSE;
+    // charge the current process up to now
+    Charge();
+    start = lastCharge;
+    if (policy == P1_SCHED_MLFQ) {
+        if (lastCharge - lastBoost >= MLFQ_BOOST) {
+            MlfqBoost();
+        }
+        if ((current != NULL) && (current->state == P1_STATE_RUNNING)) {
+            MlfqDemote(current);
+        }
+    }
     // select the highest-priority runnable process
+    if (readyLevels == 0) {
+        if ((current != NULL) && (current->state == P1_STATE_RUNNING)) {
+            goto kept;
+        }
+        USLOSS_Console("No runnable processes, halting.\n");
+        USLOSS_Halt(0);
+    }
+    priority = __builtin_ctz(readyLevels);
+    if ((current != NULL) && (current->state == P1_STATE_RUNNING)) {
+        if ((priority > current->priority) || ((priority == current->priority) && !rotate)) {
+            goto kept;
+        }
+        // under stride scheduling keep running while we're furthest behind
+        if ((policy == P1_SCHED_STRIDE) && (priority == current->priority) &&
+            (current->pass <= Proc(ReadyPeek(priority))->pass)) {
+            goto kept;
+        }
+        reason = (priority < current->priority) ? P1_TRACE_PREEMPT : P1_TRACE_ROTATE;
+        // the current process goes to the back of its queue
+        ChangeState(currentPid, P1_STATE_READY);
+    } else if (current == NULL) {
+        reason = P1_TRACE_START;
+    } else {
+        reason = (current->state == P1_STATE_QUIT) ? P1_TRACE_EXIT : P1_TRACE_BLOCK;
+    }
+    next = ReadyDequeue(priority);
+    if (Proc(next)->wokenByInterrupt) {
+        RecordWakeLatency(Proc(next));
+    }
+    Proc(next)->state = P1_STATE_RUNNING;
+    Proc(next)->sliceTicks = 0;
+    if (next == currentPid) {
+        // the current process was made READY before it could block
+        goto kept;
+    }
+    if (current != NULL) {
+        current->inInterrupt = inInterrupt;
+    }
+    TRACE(P1_TRACE_SWITCH, reason, PidOf(currentPid), PidOf(next));
+    if (current != NULL) {
+        if ((reason == P1_TRACE_PREEMPT) || (reason == P1_TRACE_ROTATE)) {
+            current->sched.involuntary++;
+            schedStats.involuntary++;
+        } else {
+            current->sched.voluntary++;
+            schedStats.voluntary++;
+        }
+    }
+    DispatchTime(current, start);
     // call P1ContextSwitch to switch to that process
+    currentPid = next;
+    rc = P1ContextSwitch(Proc(next)->cid);
+    assert(rc == P1_SUCCESS);
+    // we've been switched back to
+    inInterrupt = current->inInterrupt;
+    goto done;
+kept:
+    current->sched.noSwitch++;
+    schedStats.noSwitch++;
+    DispatchTime(current, start);
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+}
+
+// Copies the first max of pcb's children's PIDs into buf and returns how many it has.
+static int
+Children(PCB *pcb, int *buf, int max)
+{
+    int         count = 0;
+    ListNode    *lists[] = {&pcb->children, &pcb->quitChildren};
+
+    for (int i = 0; i < 2; i++) {
+        for (ListNode *node = lists[i]->next; node != lists[i]; node = node->next) {
+            if (count < max) {
+                buf[count] = PidOf(LIST_ENTRY(node, PCB, siblingLink)->pid);
+            }
+            count++;
+        }
+    }
+    return count;
 }
 
 int
 P1_GetProcInfo(int pid, P1_ProcInfo *info)
 {
     int         result = P1_SUCCESS;
+    int         enabled;
+    int         slot;
+    PCB         *pcb;
+
     // fill in info here
+    enabled = P1DisableInterrupts();
+    slot = Slot(pid);
+    if (slot == -1) {
+        result = P1_INVALID_PID;
+        goto done;
+    }
+    pcb = Proc(slot);
+    info->state = pcb->state;
+    strcpy(info->name, pcb->name);
+    info->lid = pcb->lid;
+    info->vid = pcb->vid;
+    info->priority = pcb->priority;
+    Charge();
+    info->cpu = pcb->cpuTime;
+    result = P1ContextStackUsage(pcb->cid, &info->stackUsed);
+    assert(result == P1_SUCCESS);
+    info->parent = PidOf(ParentOf(pcb));
+    info->numChildren = Children(pcb, info->children, P1_MAXPROC);
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
     return result;
 }
 
+/*
+ * Copies the PIDs of pid's children, those that have quit included, into buf and
+ * sets *count to the number of children, which may exceed max; only the first max
+ * are copied. For processes with more than P1_MAXPROC children.
+ */
+int
+P1_GetChildren(int pid, int *buf, int max, int *count)
+{
+    int         result = P1_SUCCESS;
+    int         enabled;
+    int         slot;
 
+    enabled = P1DisableInterrupts();
+    slot = Slot(pid);
+    if (slot == -1) {
+        result = P1_INVALID_PID;
+        goto done;
+    }
+    *count = Children(Proc(slot), buf, max);
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
 
+/*
+ * Copies the requested fields of every live process, in slot order, into buf in a
+ * single critical section. *count is set to the number of live processes, which may
+ * exceed cap; only the first cap are copied.
+ */
+int
+P1_SnapshotProcesses(P1_ProcSnapshot *buf, int cap, int fields, int *count)
+{
+    int             enabled;
+    int             n = 0;
+    PCB             *pcb;
+    P1_ProcSnapshot *snap;
+    ListNode        *node;
 
+    CHECKKERNEL();
+    enabled = P1DisableInterrupts();
+    if (fields & P1_SNAP_CPU) {
+        Charge();
+    }
+    for (int i = 0; i < numProcs; i++) {
+        pcb = Proc(i);
+        if (pcb->state == P1_STATE_FREE) {
+            continue;
+        }
+        if (n < cap) {
+            snap = &buf[n];
+            snap->pid = PidOf(i);
+            if (fields & P1_SNAP_NAME) {
+                strcpy(snap->name, pcb->name);
+            }
+            if (fields & P1_SNAP_STATE) {
+                snap->state = pcb->state;
+            }
+            if (fields & P1_SNAP_PRIORITY) {
+                snap->priority = pcb->priority;
+            }
+            if (fields & P1_SNAP_CPU) {
+                snap->cpu = pcb->cpuTime;
+            }
+            if (fields & P1_SNAP_BLOCKED) {
+                snap->lid = pcb->lid;
+                snap->vid = pcb->vid;
+            }
+            if (fields & P1_SNAP_PARENT) {
+                snap->parent = PidOf(ParentOf(pcb));
+            }
+            if (fields & P1_SNAP_CHILDREN) {
+                snap->numChildren = 0;
+                for (node = pcb->children.next; node != &pcb->children; node = node->next) {
+                    snap->numChildren++;
+                }
+                for (node = pcb->quitChildren.next; node != &pcb->quitChildren;
+                     node = node->next) {
+                    snap->numChildren++;
+                }
+            }
+        }
+        n++;
+    }
+    *count = n;
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return P1_SUCCESS;
+}
 
+/*
+ * Returns the scheduler statistics for process pid, or kernel-wide if pid is -1.
+ */
+int
+P1_GetSchedStats(int pid, P1_SchedStats *stats)
+{
+    int result = P1_SUCCESS;
+    int enabled;
+    int slot;
 
-
+    CHECKKERNEL();
+    enabled = P1DisableInterrupts();
+    if (pid == -1) {
+        *stats = schedStats;
+        goto done;
+    }
+    slot = Slot(pid);
+    if (slot == -1) {
+        result = P1_INVALID_PID;
+        goto done;
+    }
+    *stats = Proc(slot)->sched;
+done:
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
@@ -0,0 +1,125 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests CPU accounting. Spinner busy-waits with interrupts enabled while a clock
+ * handler that itself burns time runs on each tick; the handler's time should be
+ * charged as interrupt time rather than to Spinner. Idle is P6Proc waiting for a
+ * tick between P1Idle calls. Host load stretches the clock, so upper bounds are
+ * relative to the measured time around each fork, not to SPIN.
+ */
+
+#define SPIN        100000      // microseconds Spinner runs
+#define HANDLER     1000        // microseconds each clock interrupt takes
+#define SLACK       1000        // microseconds of clock reads around the measured span
+
+static int
+Clock(void)
+{
+    int now;
+    int rc = USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &now);
+    assert(rc == USLOSS_DEV_OK);
+    return now;
+}
+
+static void
+Burn(int usec)
+{
+    int start = Clock();
+    while (Clock() - start < usec) {
+        // let pending interrupts in
+        P1EnableInterrupts();
+    }
+}
+
+static void
+ClockHandler(int type, void *arg)
+{
+    int start = Clock();
+
+    P1InterruptEnter();
+    while (Clock() - start < HANDLER) {
+    }
+    P1InterruptExit();
+}
+
+static int
+Spinner(void *arg)
+{
+    Burn(SPIN);
+    return 0;
+}
+
+static int
+Lazy(void *arg)
+{
+    return 0;
+}
+
+int P6Proc(void *arg)
+{
+    int pid, child, status, rc;
+    int start, elapsed;
+    long long interrupt;
+    P1_ProcInfo info;
+    P1CpuStats before, after;
+
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = ClockHandler;
+
+    P1GetCpuStats(&before);
+    start = Clock();
+    rc = P1_Fork("Spinner", Spinner, NULL, USLOSS_MIN_STACK, 1, &child);
+    TEST(rc, P1_SUCCESS);
+    elapsed = Clock() - start;
+    P1GetCpuStats(&after);
+    interrupt = after.interrupt - before.interrupt;
+    rc = P1_GetProcInfo(child, &info);
+    TEST(rc, P1_SUCCESS);
+    USLOSS_Console("Spinner cpu %d interrupt %lld elapsed %d\n", info.cpu, interrupt, elapsed);
+    TEST(interrupt >= HANDLER, 1);
+    TEST(info.cpu + interrupt >= SPIN, 1);
+    // the handlers' time isn't charged to Spinner
+    TEST(info.cpu <= elapsed - interrupt + SLACK, 1);
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+
+    start = Clock();
+    rc = P1_Fork("Lazy", Lazy, NULL, USLOSS_MIN_STACK, 1, &child);
+    TEST(rc, P1_SUCCESS);
+    elapsed = Clock() - start;
+    rc = P1_GetProcInfo(child, &info);
+    TEST(rc, P1_SUCCESS);
+    TEST(info.cpu <= elapsed + SLACK, 1);
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+
+    P1GetCpuStats(&before);
+    P1Idle(TRUE);
+    USLOSS_WaitInt();
+    P1Idle(FALSE);
+    P1GetCpuStats(&after);
+    TEST(after.idle > before.idle, 1);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInit();
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
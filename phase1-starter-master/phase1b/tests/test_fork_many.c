@@ -0,0 +1,81 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests P1_ForkMany. The workers outrank P6Proc but none runs until the whole batch
+ * is created, then they run in priority order. A batch with a bad spec creates
+ * nothing.
+ */
+
+static int order[3];
+static int numRun;
+
+static int
+Worker(void *arg)
+{
+    order[numRun++] = P1_GetPid();
+    return (int) arg;
+}
+
+int P6Proc(void *arg)
+{
+    int pids[3];
+    int pid, status, rc;
+    P1_ProcInfo info;
+    P1_ForkSpec specs[3] = {
+        {"Worker0", Worker, (void *) 10, USLOSS_MIN_STACK, 2},
+        {"Worker1", Worker, (void *) 11, USLOSS_MIN_STACK, 3},
+        {"Worker2", Worker, (void *) 12, USLOSS_MIN_STACK, 2},
+    };
+
+    rc = P1_ForkMany(specs, 3, pids);
+    TEST(rc, P1_SUCCESS);
+    TEST(numRun, 3);
+    TEST(order[0], pids[0]);
+    TEST(order[1], pids[2]);
+    TEST(order[2], pids[1]);
+    for (int i = 0; i < 3; i++) {
+        rc = P1GetChildStatusPid(pids[i], &status);
+        TEST(rc, P1_SUCCESS);
+        TEST(status, 10 + i);
+    }
+
+    // the duplicate name fails the batch and Worker0 and Worker1 are freed
+    specs[2].name = "Worker0";
+    rc = P1_ForkMany(specs, 3, pids);
+    TEST(rc, P1_DUPLICATE_NAME);
+    TEST(numRun, 3);
+    rc = P1_GetProcInfo(pids[0], &info);
+    TEST(rc, P1_INVALID_PID);
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_NO_CHILDREN);
+
+    specs[2].name = "Worker2";
+    specs[1].priority = 6;
+    rc = P1_ForkMany(specs, 3, pids);
+    TEST(rc, P1_INVALID_PRIORITY);
+    TEST(numRun, 3);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInit();
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
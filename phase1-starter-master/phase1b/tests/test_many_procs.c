@@ -0,0 +1,103 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests growing the process table. With the default capacity the 51st process
+ * can't be forked; after raising the capacity to CAPACITY it can, up to CAPACITY
+ * processes. P1_GetProcInfo returns the first P1_MAXPROC children and
+ * P1_GetChildren all of them, through a caller-sized buffer. A quit child's
+ * name stays taken until it is cleaned up.
+ */
+
+#define CAPACITY 1000
+
+static int
+Child(void *arg)
+{
+    return (int) arg;
+}
+
+int P6Proc(void *arg)
+{
+    int pid, status, rc, i;
+    int count;
+    static int children[CAPACITY];
+    P1_ProcInfo info;
+
+    // children run at a higher priority, so they quit immediately but are not cleaned up
+    for (i = 1; i < P1_MAXPROC; i++) {
+        rc = P1_Fork(MakeName("Child", i), Child, (void *) i, USLOSS_MIN_STACK, 1, &pid);
+        TEST(rc, P1_SUCCESS);
+    }
+    rc = P1_Fork(MakeName("Child", i), Child, (void *) i, USLOSS_MIN_STACK, 1, &pid);
+    TEST(rc, P1_TOO_MANY_PROCESSES);
+
+    rc = P1_SetProcCapacity(P1_MAXPROC_LIMIT + 1);
+    TEST(rc, P1_TOO_MANY_PROCESSES);
+    rc = P1_SetProcCapacity(CAPACITY);
+    TEST(rc, P1_SUCCESS);
+    for (; i < CAPACITY; i++) {
+        rc = P1_Fork(MakeName("Child", i), Child, (void *) i, USLOSS_MIN_STACK, 1, &pid);
+        TEST(rc, P1_SUCCESS);
+        TEST(pid, i);
+    }
+    rc = P1_Fork(MakeName("Child", i), Child, (void *) i, USLOSS_MIN_STACK, 1, &pid);
+    TEST(rc, P1_TOO_MANY_PROCESSES);
+    rc = P1_SetProcCapacity(P1_MAXPROC);
+    TEST(rc, P1_TOO_MANY_PROCESSES);
+    rc = P1_Fork(MakeName("Child", CAPACITY / 2), Child, NULL, USLOSS_MIN_STACK, 1, &pid);
+    TEST(rc, P1_DUPLICATE_NAME);
+
+    rc = P1_GetProcInfo(0, &info);
+    TEST(rc, P1_SUCCESS);
+    TEST(info.numChildren, CAPACITY - 1);
+    for (i = 0; i < P1_MAXPROC; i++) {
+        TEST(info.children[i], i + 1);
+    }
+    rc = P1_GetChildren(0, children, 10, &count);
+    TEST(rc, P1_SUCCESS);
+    TEST(count, CAPACITY - 1);
+    rc = P1_GetChildren(0, children, CAPACITY, &count);
+    TEST(rc, P1_SUCCESS);
+    TEST(count, CAPACITY - 1);
+    for (i = 0; i < count; i++) {
+        TEST(children[i], i + 1);
+    }
+    rc = P1_GetChildren(CAPACITY, children, CAPACITY, &count);
+    TEST(rc, P1_INVALID_PID);
+
+    for (i = 1; i < CAPACITY; i++) {
+        rc = P1GetChildStatus(&pid, &status);
+        TEST(rc, P1_SUCCESS);
+        TEST(status, pid);
+    }
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_NO_CHILDREN);
+    rc = P1_Fork(MakeName("Child", CAPACITY / 2), Child, (void *) 0, USLOSS_MIN_STACK, 1, &pid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInit();
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -0,0 +1,133 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests the MLFQ policy. Hog is CPU-bound at priority 1, which would starve Low at
+ * priority 3 under fixed priorities. Under MLFQ Hog drops a level each quantum
+ * until Low gets to run, rises a level when it blocks, and is boosted back to its
+ * base priority periodically.
+ */
+
+#define TIMEOUT 3000000
+
+static int lowRan;
+static int low;
+
+static int
+Clock(void)
+{
+    int now;
+    int rc = USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &now);
+    assert(rc == USLOSS_DEV_OK);
+    return now;
+}
+
+static void
+ClockHandler(int type, void *arg)
+{
+    static int ticks = 0;
+
+    P1InterruptEnter();
+    if ((++ticks % 4) == 0) {
+        P1Dispatch(TRUE);
+    }
+    P1InterruptExit();
+}
+
+static int
+Priority(int pid)
+{
+    P1_ProcInfo info;
+    int rc = P1_GetProcInfo(pid, &info);
+    assert(rc == P1_SUCCESS);
+    return info.priority;
+}
+
+static int
+Low(void *arg)
+{
+    int rc;
+
+    // wait for Hog
+    rc = P1SetState(P1_GetPid(), P1_STATE_BLOCKED, -1, -1);
+    TEST(rc, P1_SUCCESS);
+    P1Dispatch(FALSE);
+    lowRan = TRUE;
+    return 0;
+}
+
+static int
+Hog(void *arg)
+{
+    int start, rc;
+
+    rc = P1SetState(low, P1_STATE_READY, -1, -1);
+    TEST(rc, P1_SUCCESS);
+    TEST(Priority(P1_GetPid()), 1);
+
+    // spin until demoted to Low's level and rotated out
+    start = Clock();
+    while (!lowRan && (Clock() - start < TIMEOUT)) {
+        P1EnableInterrupts();
+    }
+    TEST(lowRan, TRUE);
+    TEST(Priority(P1_GetPid()), 3);
+
+    // blocking promotes us a level
+    rc = P1SetState(P1_GetPid(), P1_STATE_BLOCKED, -1, -1);
+    TEST(rc, P1_SUCCESS);
+    P1Dispatch(FALSE);
+    TEST(Priority(P1_GetPid()), 2);
+
+    // wait for a boost
+    start = Clock();
+    while ((Priority(P1_GetPid()) != 1) && (Clock() - start < TIMEOUT)) {
+    }
+    TEST(Priority(P1_GetPid()), 1);
+    return 0;
+}
+
+int P6Proc(void *arg)
+{
+    int pid, hog, status, rc;
+
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = ClockHandler;
+    rc = P1_Fork("Low", Low, NULL, USLOSS_MIN_STACK, 3, &low);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Fork("Hog", Hog, NULL, USLOSS_MIN_STACK, 1, &hog);
+    TEST(rc, P1_SUCCESS);
+
+    // Hog is blocked
+    rc = P1SetState(hog, P1_STATE_READY, -1, -1);
+    TEST(rc, P1_SUCCESS);
+    P1Dispatch(FALSE);
+
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(pid, hog);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInitPolicy(P1_SCHED_MLFQ);
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
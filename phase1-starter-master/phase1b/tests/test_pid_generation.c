@@ -0,0 +1,81 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests generation-tagged PIDs. A child forked after another is reaped reuses its
+ * slot but gets a new PID, and the old PID is rejected everywhere.
+ */
+
+static int
+Child(void *arg)
+{
+    return (int) arg;
+}
+
+int P6Proc(void *arg)
+{
+    int first, second, pid, status, rc;
+    P1_ProcInfo info;
+
+    rc = P1_Fork("First", Child, (void *) 1, USLOSS_MIN_STACK, 1, &first);
+    TEST(rc, P1_SUCCESS);
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(pid, first);
+    TEST(status, 1);
+
+    // the next child gets the same slot, and stays around until it is reaped
+    rc = P1_Fork("Second", Child, (void *) 2, USLOSS_MIN_STACK, 5, &second);
+    TEST(rc, P1_SUCCESS);
+    TEST(P1PidSlot(second), P1PidSlot(first));
+    TEST(second != first, 1);
+
+    rc = P1_GetProcInfo(first, &info);
+    TEST(rc, P1_INVALID_PID);
+    rc = P1SetState(first, P1_STATE_BLOCKED, -1, -1);
+    TEST(rc, P1_INVALID_PID);
+    rc = P1_SetTickets(first, 10);
+    TEST(rc, P1_INVALID_PID);
+    TEST(P1GetPriority(first), P1_INVALID_PID);
+    rc = P1GetChildStatusPid(first, &status);
+    TEST(rc, P1_INVALID_PID);
+    rc = P1SetJoiningPid(first);
+    TEST(rc, P1_INVALID_PID);
+    rc = P1_GetProcInfo(-1, &info);
+    TEST(rc, P1_INVALID_PID);
+
+    rc = P1_GetProcInfo(second, &info);
+    TEST(rc, P1_SUCCESS);
+    TEST(info.state, P1_STATE_QUIT);
+    TEST(info.parent, P1_GetPid());
+    TEST(P1GetPriority(second), 5);
+
+    rc = P1GetChildStatusPid(second, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(status, 2);
+    rc = P1_GetProcInfo(second, &info);
+    TEST(rc, P1_INVALID_PID);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInit();
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
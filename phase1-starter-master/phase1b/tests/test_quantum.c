@@ -0,0 +1,146 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests per-priority and adaptive quanta. The clock handler calls P1Tick like the
+ * one in phase 1d. A process spinning alone never needs rotating, so its rotations
+ * are avoided. Two processes sharing a priority with a 1-tick quantum alternate on
+ * about every tick, and four sharing a 4-tick quantum switch about twice as often
+ * with adaptive quanta, which cut it to 2 ticks.
+ */
+
+#define SPIN 400000
+
+static int last = -1;
+static int switches = 0;
+
+static int
+Clock(void)
+{
+    int now;
+    int rc = USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &now);
+    assert(rc == USLOSS_DEV_OK);
+    return now;
+}
+
+static void
+ClockHandler(int type, void *arg)
+{
+    P1InterruptEnter();
+    P1Tick();
+    P1InterruptExit();
+}
+
+static int
+Spin(void *arg)
+{
+    int start = Clock();
+
+    while (Clock() - start < SPIN) {
+        if (last != P1_GetPid()) {
+            last = P1_GetPid();
+            switches++;
+        }
+        P1EnableInterrupts();
+    }
+    return 0;
+}
+
+// forks (int) arg spinners together at priority 3, so none runs until all exist
+static int
+Group(void *arg)
+{
+    int pid, rc;
+
+    for (int i = 0; i < (int) (long) arg; i++) {
+        rc = P1_Fork(MakeName("Spin", i), Spin, NULL, USLOSS_MIN_STACK, 3, &pid);
+        TEST(rc, P1_SUCCESS);
+    }
+    return 0;
+}
+
+static void
+Reap(int n)
+{
+    int pid, status, rc;
+
+    for (int i = 0; i < n; i++) {
+        rc = P1GetChildStatus(&pid, &status);
+        TEST(rc, P1_SUCCESS);
+    }
+}
+
+// returns how many times n spinners sharing priority 3 switched
+static int
+Switches(int n)
+{
+    int pid, rc;
+
+    last = -1;
+    switches = 0;
+    rc = P1_Fork("Group", Group, (void *) (long) n, USLOSS_MIN_STACK, 1, &pid);
+    TEST(rc, P1_SUCCESS);
+    Reap(n + 1);    // Group and its orphans
+    return switches;
+}
+
+int P6Proc(void *arg)
+{
+    int pid, rc, avoided, fixed, adaptive;
+
+    rc = P1SetQuantum(0, 1);
+    TEST(rc, P1_INVALID_PRIORITY);
+    rc = P1SetQuantum(2, 0);
+    TEST(rc, P1_INVALID_QUANTUM);
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = ClockHandler;
+
+    // alone for 20 ticks with a 1-tick quantum, so about 20 rotations are avoided
+    rc = P1SetQuantum(2, 1);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Fork("Alone", Spin, NULL, USLOSS_MIN_STACK, 2, &pid);
+    TEST(rc, P1_SUCCESS);
+    Reap(1);
+    avoided = P1GetRotationsAvoided();
+    USLOSS_Console("alone avoided %d rotations\n", avoided);
+    TEST(avoided >= 10, 1);
+
+    // two processes with a 1-tick quantum alternate on every tick
+    rc = P1SetQuantum(3, 1);
+    TEST(rc, P1_SUCCESS);
+    fixed = Switches(2);
+    USLOSS_Console("2 processes switched %d times\n", fixed);
+    TEST(fixed >= 10, 1);
+
+    // adaptive quanta shorten the 4-tick quantum to 2 ticks for four processes
+    rc = P1SetQuantum(3, 4);
+    TEST(rc, P1_SUCCESS);
+    fixed = Switches(4);
+    P1SetAdaptiveQuantum(TRUE);
+    adaptive = Switches(4);
+    P1SetAdaptiveQuantum(FALSE);
+    USLOSS_Console("4 processes switched %d times, %d adaptive\n", fixed, adaptive);
+    TEST(adaptive > fixed, 1);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInit();
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
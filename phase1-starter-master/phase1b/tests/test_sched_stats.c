@@ -0,0 +1,92 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <string.h>
+#include <tester.h>
+
+/*
+ * Tests P1_GetSchedStats. Forking Starter preempts P6Proc. Starter forks two
+ * lower-priority children, samples the ready queues with P1Tick, and makes a
+ * P1Dispatch call that keeps it running. Starter and both children then quit,
+ * which are voluntary switches.
+ */
+
+static int starter;
+
+static int
+Child(void *arg)
+{
+    return 0;
+}
+
+static int
+Starter(void *arg)
+{
+    int pid, rc;
+
+    rc = P1_Fork("A", Child, NULL, USLOSS_MIN_STACK, 3, &pid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Fork("B", Child, NULL, USLOSS_MIN_STACK, 3, &pid);
+    TEST(rc, P1_SUCCESS);
+    // A, B, and P6Proc are READY
+    P1Tick();
+    P1Tick();
+    P1Dispatch(FALSE);
+    return 0;
+}
+
+int P6Proc(void *arg)
+{
+    int rc;
+    P1_SchedStats stats;
+
+    rc = P1_Fork("Starter", Starter, NULL, USLOSS_MIN_STACK, 1, &starter);
+    TEST(rc, P1_SUCCESS);
+
+    rc = P1_GetSchedStats(P1_GetPid(), &stats);
+    TEST(rc, P1_SUCCESS);
+    TEST(stats.involuntary, 1);
+    TEST(stats.voluntary, 0);
+    TEST(stats.readySamples, 0);
+
+    rc = P1_GetSchedStats(starter, &stats);
+    TEST(rc, P1_SUCCESS);
+    TEST(stats.involuntary, 0);
+    TEST(stats.voluntary, 1);
+    TEST(stats.noSwitch, 1);
+
+    rc = P1_GetSchedStats(-1, &stats);
+    TEST(rc, P1_SUCCESS);
+    TEST(stats.involuntary, 1);
+    TEST(stats.voluntary, 3);
+    TEST(stats.noSwitch, 1);
+    TEST(stats.readySamples, 2);
+    TEST(stats.readyMin, 3);
+    TEST(stats.readyMax, 3);
+    TEST(stats.readyTotal, 6);
+    TEST(stats.dispatchTime >= 0, 1);
+
+    rc = P1_GetSchedStats(P1_GetPid() + 1000, &stats);
+    TEST(rc, P1_INVALID_PID);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInit();
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
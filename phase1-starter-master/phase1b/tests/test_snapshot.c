@@ -0,0 +1,87 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <string.h>
+#include <tester.h>
+
+/*
+ * Tests P1_SnapshotProcesses. The snapshot should agree with P1_GetProcInfo for
+ * every live process, copy only the requested fields, and count processes beyond
+ * its capacity.
+ */
+
+static int
+Child(void *arg)
+{
+    return (int) arg;
+}
+
+int P6Proc(void *arg)
+{
+    int pids[4];
+    int count, rc;
+    P1_ProcInfo info;
+    P1_ProcSnapshot procs[10];
+
+    for (int i = 0; i < 4; i++) {
+        // the children outrank us, so they run and quit right away
+        rc = P1_Fork(MakeName("Child", i), Child, (void *) i, USLOSS_MIN_STACK, (i % 2) ? 1 : 5,
+                     &pids[i]);
+        TEST(rc, P1_SUCCESS);
+    }
+    rc = P1_SnapshotProcesses(procs, 10, P1_SNAP_ALL, &count);
+    TEST(rc, P1_SUCCESS);
+    TEST(count, 5);
+    for (int i = 0; i < count; i++) {
+        rc = P1_GetProcInfo(procs[i].pid, &info);
+        TEST(rc, P1_SUCCESS);
+        TEST(strcmp(procs[i].name, info.name), 0);
+        TEST(procs[i].state, info.state);
+        TEST(procs[i].priority, info.priority);
+        TEST(procs[i].cpu <= info.cpu, 1);
+        TEST(procs[i].lid, info.lid);
+        TEST(procs[i].vid, info.vid);
+        TEST(procs[i].parent, info.parent);
+        TEST(procs[i].numChildren, info.numChildren);
+    }
+    TEST(procs[0].pid, P1_GetPid());
+    TEST(procs[0].numChildren, 4);
+    TEST(procs[0].state, P1_STATE_RUNNING);
+    TEST(procs[3].state, P1_STATE_QUIT);
+    TEST(procs[3].priority, 5);
+
+    // only the requested fields are copied, and the count includes what didn't fit
+    memset(procs, 0xff, sizeof(procs));
+    rc = P1_SnapshotProcesses(procs, 2, P1_SNAP_STATE | P1_SNAP_PARENT, &count);
+    TEST(rc, P1_SUCCESS);
+    TEST(count, 5);
+    TEST(procs[1].pid, pids[0]);
+    TEST(procs[1].state, P1_STATE_QUIT);
+    TEST(procs[1].parent, P1_GetPid());
+    TEST(procs[1].priority, -1);
+    TEST(procs[1].name[0], (char) 0xff);
+    TEST(procs[2].pid, -1);
+
+    DumpProcesses();
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInit();
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -0,0 +1,84 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests stack high-water measurement and auto-sizing. Deep zeroes 20000 bytes of
+ * stack, so its high-water mark should be at least that but well under its
+ * 4 * USLOSS_MIN_STACK stack. Auto-sizing, which turns measurement on, then gives
+ * the next fork of Deep a smaller stack, so it can't reuse the pooled
+ * 4 * USLOSS_MIN_STACK stack.
+ */
+
+#define DEPTH 20000
+
+static int
+Deep(void *arg)
+{
+    volatile char buf[DEPTH];
+    // zeroed frames must count as used too. A loop rather than memset, so nothing
+    // deeper than buf is written
+    for (int i = 0; i < DEPTH; i++) {
+        buf[i] = 0;
+    }
+    return buf[0] + buf[DEPTH - 1];
+}
+
+int P6Proc(void *arg)
+{
+    int pid, child, status, rc;
+    P1_ProcInfo info;
+    P1StackPoolStats before, after;
+
+    P1StackAutoSize(TRUE);
+
+    // Deep runs at a lower priority so we can look at it after it quits
+    rc = P1_Fork("Deep", Deep, NULL, 4 * USLOSS_MIN_STACK, 6, &child);
+    TEST(rc, P1_INVALID_PRIORITY);
+    rc = P1_Fork("Deep", Deep, NULL, 4 * USLOSS_MIN_STACK, 1, &child);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_GetProcInfo(child, &info);
+    TEST(rc, P1_SUCCESS);
+    TEST(info.state, P1_STATE_QUIT);
+    TEST(info.stackUsed >= DEPTH, 1);
+    TEST(info.stackUsed < 2 * USLOSS_MIN_STACK, 1);
+    USLOSS_Console("Deep used %d bytes of stack.\n", info.stackUsed);
+
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(pid, child);
+    TEST(status, 0);
+
+    P1StackPoolGetStats(&before);
+    rc = P1_Fork("Deep", Deep, NULL, 4 * USLOSS_MIN_STACK, 1, &child);
+    TEST(rc, P1_SUCCESS);
+    P1StackPoolGetStats(&after);
+    TEST(after.hits, before.hits);
+    TEST(after.retained, before.retained);
+
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(status, 0);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInit();
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
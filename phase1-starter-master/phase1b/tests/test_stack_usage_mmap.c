@@ -0,0 +1,11 @@
+/*
+ * test_stack_usage with the mmap stack backend, whatever the build's CFLAGS. The
+ * test is compiled together with phase1a.c and MMAP_STACKS defined, so the linker
+ * doesn't pull phase1a from the library.
+ */
+
+#ifndef MMAP_STACKS
+#define MMAP_STACKS
+#endif
+#include "../../phase1a/phase1a.c"
+#include "test_stack_usage.c"
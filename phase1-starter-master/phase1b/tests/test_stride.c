@@ -0,0 +1,115 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <string.h>
+#include <tester.h>
+
+/*
+ * Tests stride scheduling. Heavy and Light spin at the same priority for the same
+ * wall-clock period with 3:1 tickets, rotated on every clock tick, so Heavy should
+ * get about three times the CPU of Light. Starter forks them both at a lower
+ * priority so neither starts before the other exists.
+ */
+
+#define PERIOD 1000000
+
+static int deadline;
+static int heavy, light;
+
+static int
+Clock(void)
+{
+    int now;
+    int rc = USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &now);
+    assert(rc == USLOSS_DEV_OK);
+    return now;
+}
+
+static void
+ClockHandler(int type, void *arg)
+{
+    P1InterruptEnter();
+    P1Dispatch(TRUE);
+    P1InterruptExit();
+}
+
+static int
+Spin(void *arg)
+{
+    while (Clock() < deadline) {
+        P1EnableInterrupts();
+    }
+    return 0;
+}
+
+static int
+Starter(void *arg)
+{
+    int rc;
+
+    rc = P1_ForkTickets("Heavy", Spin, NULL, USLOSS_MIN_STACK, 2, 100, &heavy);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Fork("Light", Spin, NULL, USLOSS_MIN_STACK, 2, &light);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_SetTickets(heavy, 3 * P1_DEFAULT_TICKETS);
+    TEST(rc, P1_SUCCESS);
+    return 0;
+}
+
+int P6Proc(void *arg)
+{
+    int pid, status, rc;
+    P1_ProcInfo heavyInfo, lightInfo;
+
+    rc = P1_ForkTickets("Bad", Spin, NULL, USLOSS_MIN_STACK, 2, 0, &pid);
+    TEST(rc, P1_INVALID_TICKETS);
+    rc = P1_SetTickets(P1_GetPid(), P1_MAX_TICKETS + 1);
+    TEST(rc, P1_INVALID_TICKETS);
+    rc = P1_SetTickets(P1_MAXPROC_LIMIT, 10);
+    TEST(rc, P1_INVALID_PID);
+
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = ClockHandler;
+    deadline = Clock() + PERIOD;
+    rc = P1_Fork("Starter", Starter, NULL, USLOSS_MIN_STACK, 1, &pid);
+    TEST(rc, P1_SUCCESS);
+
+    // P6Proc only runs again after Heavy and Light have quit
+    memset(&heavyInfo, 0, sizeof(heavyInfo));
+    memset(&lightInfo, 0, sizeof(lightInfo));
+    rc = P1_GetProcInfo(heavy, &heavyInfo);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_GetProcInfo(light, &lightInfo);
+    TEST(rc, P1_SUCCESS);
+    TEST(heavyInfo.state, P1_STATE_QUIT);
+    TEST(lightInfo.state, P1_STATE_QUIT);
+    USLOSS_Console("Heavy %d us, Light %d us\n", heavyInfo.cpu, lightInfo.cpu);
+    TEST(heavyInfo.cpu > 2 * lightInfo.cpu, 1);
+    TEST(heavyInfo.cpu < 4 * lightInfo.cpu, 1);
+
+    // Starter, and Heavy and Light which we inherited
+    for (int i = 0; i < 3; i++) {
+        rc = P1GetChildStatus(&pid, &status);
+        TEST(rc, P1_SUCCESS);
+    }
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInitPolicy(P1_SCHED_STRIDE);
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -0,0 +1,83 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests the scheduler trace. Child has a higher priority than P6Proc, so forking it
+ * preempts P6Proc and Child quitting switches back. Without -DP1_TRACE nothing is
+ * recorded.
+ */
+
+static int
+Child(void *arg)
+{
+    return 3;
+}
+
+int P6Proc(void *arg)
+{
+    P1TraceEvent events[8];
+    int pid, child, status, rc, count;
+
+    rc = P1_Fork("Child", Child, NULL, USLOSS_MIN_STACK, 1, &child);
+    TEST(rc, P1_SUCCESS);
+    count = P1TraceSnapshot(events, 8);
+#ifdef P1_TRACE
+    TEST(count, 6);
+    // startup forking P6Proc and the first dispatch come first
+    TEST(events[0].type, P1_TRACE_FORK);
+    TEST(events[0].pid, -1);
+    TEST(events[1].type, P1_TRACE_SWITCH);
+    TEST(events[1].arg, P1_TRACE_START);
+    TEST(events[1].other, P1_GetPid());
+    TEST(events[2].type, P1_TRACE_FORK);
+    TEST(events[2].pid, P1_GetPid());
+    TEST(events[2].other, child);
+    TEST(events[2].arg, 1);
+    TEST(events[3].type, P1_TRACE_SWITCH);
+    TEST(events[3].arg, P1_TRACE_PREEMPT);
+    TEST(events[3].other, child);
+    TEST(events[4].type, P1_TRACE_QUIT);
+    TEST(events[4].pid, child);
+    TEST(events[4].other, 3);
+    TEST(events[5].type, P1_TRACE_SWITCH);
+    TEST(events[5].arg, P1_TRACE_EXIT);
+    TEST(events[5].pid, child);
+    TEST(events[5].other, P1_GetPid());
+    TEST(events[5].time - events[0].time < 1000000, 1);
+
+    // the snapshot keeps the most recent events
+    count = P1TraceSnapshot(events, 2);
+    TEST(count, 2);
+    TEST(events[0].type, P1_TRACE_QUIT);
+
+    rc = P1TraceDump("trace.bin");
+    TEST(rc, 6);
+#else
+    TEST(count, 0);
+#endif
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+    P1ProcInit();
+    USLOSS_Console("startup\n");
+    rc = P1_Fork("P6Proc", P6Proc, NULL, USLOSS_MIN_STACK, 6, &pid);
+    TEST(rc, P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -15,26 +15,214 @@
 #define FREE 0
 #define BUSY 1
 
+#define PRIORITIES 7                // process priorities are 1 (highest) to 6
+
 // struct that creates nodes for the Queue of objects
 // in line to grab the lock
 typedef struct LockQ {
     int             pid;
+    int             priority;       // priority counted in its lock's waiters
     struct LockQ    *next;
 } LockQ;
 
+// FIFO queue of waiting processes. Processes are appended at the tail and woken
+// from the head, both in constant time
+typedef struct WaitQueue {
+    LockQ           *head;          // longest waiting, NULL if empty
+    LockQ           *tail;          // most recent
+} WaitQueue;
+
+static void QueueInit(WaitQueue *queue){
+    queue->head = NULL;
+    queue->tail = NULL;
+}
+
+static int QueueEmpty(WaitQueue *queue){
+    return queue->head == NULL;
+}
+
+static void QueueAppend(WaitQueue *queue, LockQ *node){
+    node->next = NULL;
+    if(queue->tail == NULL){
+        queue->head = node;
+    } else {
+        queue->tail->next = node;
+    }
+    queue->tail = node;
+}
+
+// removes the longest waiting process from a non-empty queue and returns its pid
+static int QueuePop(WaitQueue *queue){
+    LockQ *node = queue->head;
+
+    queue->head = node->next;
+    if(queue->head == NULL){
+        queue->tail = NULL;
+    }
+    return node->pid;
+}
+
+// lock and condition ids by name
+static P1NameIndex lockNames;
+static P1NameIndex condNames;
+
 // struct that creates lock "object" and its associated variables
 typedef struct Lock {
     int         inuse;
     char        name[P1_MAXNAME];
     int         state;              // BUSY or FREE
     int         pid;                // process id that currently holds lock
-    int         vid;                // condition variable for lock
-    LockQ       ElQueue;            // queue for processes waiting on lock
+    int         numConds;           // # of condition variables using this lock
+    int         condWaiters;        // # of processes waiting on those conditions
+    WaitQueue   ElQueue;            // queue for processes waiting on lock
+    int         waiters[PRIORITIES];    // # of processes in ElQueue at each priority
+    int         nextHeld;           // next lock held by the same process, -1 if none
     // more fields here
 } Lock;
 
 static Lock locks[P1_MAXLOCKS];
+static P1Bitmap freeLocks;          // free slots in locks
+
+// each process's wait queue node. A process waits on one lock or condition at a
+// time, so blocking never allocates; indexed by the process's slot
+static LockQ waitNodes[P1_MAXPROC_LIMIT];
+
+// for priority inheritance, the locks each process holds and the lock it's waiting
+// for, indexed by the process's slot (see P1PidSlot)
+static int heldLocks[P1_MAXPROC_LIMIT];     // first lock held, chained through nextHeld
+static int waitingFor[P1_MAXPROC_LIMIT];    // lock blocked on, -1 if none
+
+// Raises the holder of lock lid to priority, then the holder of the lock that
+// process is waiting for, and so on down the chain. The walk stops at a holder
+// that is already at least that priority, so a deadlock cycle ends after one lap.
+static void InheritPriority(int lid, int priority){
+    int holder;
+    int rc;
+    LockQ *node;
+
+    while(lid != -1){
+        holder = locks[lid].pid;
+        if(holder == -1 || P1GetPriority(holder) <= priority){
+            break;
+        }
+        rc = P1SetInheritedPriority(holder, priority);
+        assert(rc == P1_SUCCESS);
+        lid = waitingFor[P1PidSlot(holder)];
+        if(lid != -1){
+            // the holder is queued for that lock, count it at its new priority
+            node = &waitNodes[P1PidSlot(holder)];
+            locks[lid].waiters[node->priority]--;
+            node->priority = priority;
+            locks[lid].waiters[priority]++;
+        }
+    }
+}
+
+// Sets the priority pid inherits to that of the highest-priority process waiting
+// for any lock it still holds, or removes it if there are none. Reads each lock's
+// waiter counts rather than its queue, so it doesn't depend on how many wait.
+static void RecomputeInheritance(int pid){
+    int best = 0;
+    int priority;
+    int rc;
+
+    for(int lid = heldLocks[P1PidSlot(pid)]; lid != -1; lid = locks[lid].nextHeld){
+        for(priority = 1; priority < PRIORITIES; priority++){
+            if(locks[lid].waiters[priority] > 0){
+                break;
+            }
+        }
+        if(priority < PRIORITIES && (best == 0 || priority < best)){
+            best = priority;
+        }
+    }
+    rc = P1SetInheritedPriority(pid, best);
+    assert(rc == P1_SUCCESS);
+}
+
+// Queues pid's node for lock lid, counts it at its priority, and passes that
+// priority on to the holder.
+static void LockEnqueue(int lid, int pid){
+    LockQ *node = &waitNodes[P1PidSlot(pid)];
+
+    node->pid = pid;
+    node->priority = P1GetPriority(pid);
+    assert(node->priority > 0 && node->priority < PRIORITIES);
+    QueueAppend(&locks[lid].ElQueue, node);
+    locks[lid].waiters[node->priority]++;
+    waitingFor[P1PidSlot(pid)] = lid;
+    InheritPriority(lid, node->priority);
+}
+
+// removes the longest waiting process from lock lid's non-empty queue and
+// returns its pid
+static int LockDequeue(int lid){
+    int pid = QueuePop(&locks[lid].ElQueue);
 
+    locks[lid].waiters[waitNodes[P1PidSlot(pid)].priority]--;
+    return pid;
+}
+
+
+// returns the current process's wait queue node
+static LockQ *WaitNode(void){
+    LockQ *node = &waitNodes[P1PidSlot(P1_GetPid())];
+
+    node->pid = P1_GetPid();
+    return node;
+}
+
+// returns TRUE if the current process holds lock lid
+static int HoldsLock(int lid){
+    return locks[lid].state == BUSY && locks[lid].pid == P1_GetPid();
+}
+
+// Makes pid the holder of lock lid. P1_Unlock uses this to hand the lock straight
+// to the longest waiter, so a woken waiter already holds it and never races for it.
+static void GrantLock(int lid, int pid){
+    Lock *lock = &locks[lid];
+
+    lock->state = BUSY;
+    lock->pid = pid;
+    waitingFor[P1PidSlot(pid)] = -1;
+    lock->nextHeld = heldLocks[P1PidSlot(pid)];
+    heldLocks[P1PidSlot(pid)] = lid;
+    // inherit from whoever is still waiting for the lock
+    RecomputeInheritance(pid);
+}
+
+// Frees lock lid, already unchained from its holder's heldLocks, or hands it to
+// the longest waiter and makes that ready. Returns TRUE if it woke a waiter.
+static int ReleaseLock(int lid){
+    Lock *lock = &locks[lid];
+    int next;
+    int rc;
+
+    if(QueueEmpty(&lock->ElQueue)){
+        lock->state = FREE;
+        lock->pid = -1;
+        return FALSE;
+    }
+    next = LockDequeue(lid);
+    GrantLock(lid, next);
+    rc = P1SetState(next, P1_STATE_READY, lid, -1);
+    assert(rc == P1_SUCCESS);
+    return TRUE;
+}
+
+// Called by P1_Quit. Releases every lock the quitting process still holds, so its
+// waiters don't block forever, and clears its slot for the next process to use it.
+static void QuitHook(int pid){
+    int slot = P1PidSlot(pid);
+    int lid;
+
+    while(heldLocks[slot] != -1){
+        lid = heldLocks[slot];
+        heldLocks[slot] = locks[lid].nextHeld;
+        ReleaseLock(lid);
+    }
+    waitingFor[slot] = -1;
+}
 
 // init locks. Must be called before other lock functions
 void P1LockInit(void) {
@@ -43,6 +231,13 @@ void P1LockInit(void) {
     for (int i = 0; i < P1_MAXLOCKS; i++) {
         locks[i].inuse = FALSE;
     }
+    for (int i = 0; i < P1_MAXPROC_LIMIT; i++) {
+        heldLocks[i] = -1;
+        waitingFor[i] = -1;
+    }
+    P1BitmapInit(&freeLocks, P1_MAXLOCKS);
+    P1NameIndexInit(&lockNames);
+    P1SetQuitHook(QuitHook);
 }
 
 // create new lock named name. Return unique id for it in *lid.
@@ -50,86 +245,89 @@ void P1LockInit(void) {
 int P1_LockCreate(char *name, int *lid){
     int interruptVal;
     int result = P1_SUCCESS;
-    int i = 0;
     int lockId = -1;
     Lock *currentLock;
-    LockQ *elQueue; 
     CHECKKERNEL();
     // disable interrupts
     interruptVal = P1DisableInterrupts();
 
     if(NULL == name){
+        if(interruptVal) P1EnableInterrupts();
         return P1_NAME_IS_NULL;
     }
     // check parameters
-    for(i = 0; i < P1_MAXLOCKS;i++){
-        if(strcmp(name,locks[i].name) == 0){
-            return P1_DUPLICATE_NAME;
-        }
+    if(P1NameIndexFind(&lockNames, name) != -1){
+        if(interruptVal) P1EnableInterrupts();
+        return P1_DUPLICATE_NAME;
     }
-    if(strlen(name) > P1_MAXNAME){
+    if(strlen(name) >= P1_MAXNAME){
+        if(interruptVal) P1EnableInterrupts();
         return P1_NAME_TOO_LONG;
     }
-    // check if all locks in use
-    for(i = 0;i < P1_MAXLOCKS;i++){
-        // open lock
-        if(locks[i].inuse == 0){
-            lockId = i;
-            break;
-        }
-    }
+    // grab the lowest open lock
+    lockId = P1BitmapAlloc(&freeLocks);
     if(lockId == -1){
+        if(interruptVal) P1EnableInterrupts();
         return P1_TOO_MANY_LOCKS;
     }
 
     // find an unused Lock and initialize it
     currentLock = &locks[lockId];
-    elQueue = malloc(sizeof(LockQ));
 
     strcpy(currentLock->name, name);
-    currentLock->pid = P1_GetPid();
+    P1NameIndexInsert(&lockNames, currentLock->name, lockId);
+    currentLock->pid = -1;
     currentLock->state = FREE;
     currentLock->inuse = 1;
-    currentLock->ElQueue = *elQueue;
-    currentLock->ElQueue.next = NULL;
-    currentLock->ElQueue.pid = -1;
-    currentLock->vid = -1;
+    QueueInit(&currentLock->ElQueue);
+    memset(currentLock->waiters, 0, sizeof(currentLock->waiters));
+    currentLock->numConds = 0;
+    currentLock->condWaiters = 0;
     *lid = lockId;
     
     // restore interrupts
-    P1EnableInterrupts();
+    if(interruptVal) P1EnableInterrupts();
     return result;
 }
 
 // Checks to see if the lock trying to be freed has processes blocked
 // If there are no blocked processes then set all fields of the struct
-// to their original values
+// to their original values. A lock that is held, or that conditions were
+// created on and not yet freed, is P1_LOCK_HELD
 int P1_LockFree(int lid) {
     int     result = P1_SUCCESS;
     Lock *currentLock;
     CHECKKERNEL();
     // disable interrupts
     int interruptVal = P1DisableInterrupts();
-    if(interruptVal);
-    // check if any processes are waiting on lock
-    if(NULL == locks[lid].ElQueue.next){
+    if(lid < 0 || lid >= P1_MAXLOCKS || locks[lid].inuse == 0){
+        if(interruptVal) P1EnableInterrupts();
+        return P1_INVALID_LOCK;
+    }
+    // check if any processes are waiting on lock, or will want it back once
+    // their condition is signaled
+    if(!QueueEmpty(&locks[lid].ElQueue) || locks[lid].condWaiters > 0){
+        if(interruptVal) P1EnableInterrupts();
         return P1_BLOCKED_PROCESSES; 
     }
-
-    if(lid < 0 || lid >= P1_MAXLOCKS){
-        return P1_INVALID_LOCK;
+    // the holder still has it chained in its heldLocks, and conditions
+    // still refer to it by lid
+    if(locks[lid].state == BUSY || locks[lid].numConds > 0){
+        if(interruptVal) P1EnableInterrupts();
+        return P1_LOCK_HELD;
     }
 
     // mark lock as unused and clean up any state
     currentLock = &locks[lid];
+    P1NameIndexRemove(&lockNames, currentLock->name);
     strcpy(currentLock->name, "");
     currentLock->pid = -1;
     currentLock->state = FREE;
     currentLock->inuse = 0;
-    currentLock->vid = -1;
+    P1BitmapFree(&freeLocks, lid);
 
     // restore interrupts
-    P1EnableInterrupts();
+    if(interruptVal) P1EnableInterrupts();
     return result;
 }
 
@@ -141,7 +339,6 @@ int P1_Lock(int lid) {
     int stateVal;
     int result = P1_SUCCESS;
     //int i = 0;
-    LockQ *curr;
     //LockQ temp;
     Lock *currentLock;
 
@@ -151,29 +348,23 @@ int P1_Lock(int lid) {
     }
 
     currentLock = &locks[lid];
-    while(1){
-        interruptVal = P1DisableInterrupts();
-        if(currentLock->state == FREE){
-            //printf("lock status now busy\n");
-            currentLock->state = BUSY;
-            break;
-        }
+    interruptVal = P1DisableInterrupts();
+    if(interruptVal);
+    if(currentLock->state == FREE){
+        GrantLock(lid, P1_GetPid());
+    } else {
         // gets current process id and sets to state blocked
-        // vid is passed in as -1
-        stateVal = P1SetState(P1_GetPid(), P1_STATE_BLOCKED, lid, currentLock->vid);
-        
-        // adds new process to head of locks queue
-        curr = malloc(sizeof(LockQ));
-        curr->pid = P1_GetPid();
-        curr->next = currentLock->ElQueue.next;
-        currentLock->ElQueue.next = curr;
-        // enable interrupts and dispatches
-        P1EnableInterrupts();
+        // vid is passed in as -1, it's waiting for the lock, not a condition
+        stateVal = P1SetState(P1_GetPid(), P1_STATE_BLOCKED, lid, -1);
+        if(stateVal);
+
+        // adds new process to the tail of the lock's queue; the holder, and
+        // anyone it's waiting for, runs at least at our priority
+        LockEnqueue(lid, P1_GetPid());
         P1Dispatch(FALSE);
+        // P1_Unlock handed us the lock before waking us
+        assert(currentLock->pid == P1_GetPid());
     }
-    currentLock->inuse = 1;
-    currentLock->pid = P1_GetPid();
-
     P1EnableInterrupts();
     return result;
 }
@@ -183,11 +374,9 @@ int P1_Lock(int lid) {
 // If there is no other processes in the queue then set the current pid to -1
 int P1_Unlock(int lid) {
     int result = P1_SUCCESS;
-    LockQ *curr;
-    LockQ *prev;
     Lock *currentLock;
     int interruptVal;
-    int stateVal;
+    int *held;
 
     CHECKKERNEL();
 
@@ -196,31 +385,23 @@ int P1_Unlock(int lid) {
         return P1_INVALID_LOCK;
     }
     currentLock = &locks[lid];
-    if(currentLock->pid != P1_GetPid()){
+    if(!HoldsLock(lid)){
         return P1_LOCK_NOT_HELD;
     }
     interruptVal = P1DisableInterrupts();
     if(interruptVal);
 
-    currentLock->state = FREE;
-    // if lock queue is not empty
-    if(NULL != currentLock->ElQueue.next){
-        curr = currentLock->ElQueue.next;
-        prev = &currentLock->ElQueue;
-        // get to the tail of the queue
-        while(NULL != curr->next){
-            prev = curr;
-            curr = curr->next;
-        }
-        // remove tail node
-        prev->next = NULL;
-        // set current process id to ready
-        stateVal = P1SetState(curr->pid, P1_STATE_READY, lid, currentLock->vid);
-        // free previous tail node
-        //free(prev);
+    held = &heldLocks[P1PidSlot(P1_GetPid())];
+    while(*held != lid){
+        held = &locks[*held].nextHeld;
+    }
+    *held = currentLock->nextHeld;
+    // drop the priority inherited through this lock
+    RecomputeInheritance(P1_GetPid());
+    // hand the lock to the longest waiting process, which may outrank us
+    if(ReleaseLock(lid)){
         P1Dispatch(FALSE);
     }
-    currentLock->pid = -1;
     P1EnableInterrupts();
     return result;
 }
@@ -251,6 +432,27 @@ int P1_LockName(int lid, char *name, int len) {
     return result;
 }
 
+// Looks up the lock named name and returns its id in *lid
+int P1_LockFind(char *name, int *lid) {
+    int result = P1_SUCCESS;
+    int lockId;
+    int interruptVal;
+
+    CHECKKERNEL();
+    if(NULL == name){
+        return P1_NAME_IS_NULL;
+    }
+    interruptVal = P1DisableInterrupts();
+    lockId = P1NameIndexFind(&lockNames, name);
+    if(lockId == -1){
+        result = P1_INVALID_LOCK;
+    } else {
+        *lid = lockId;
+    }
+    if(interruptVal) P1EnableInterrupts();
+    return result;
+}
+
 /*
  * Condition variable functions.
  */
@@ -260,11 +462,12 @@ typedef struct Condition{
     char        name[P1_MAXNAME];
     int         lid;                // lock associated with this variable
     int         numWaiting;
-    LockQ       CondQueue;
+    WaitQueue   CondQueue;
     // more fields here
 } Condition;
 
 static Condition conditions[P1_MAXCONDS];
+static P1Bitmap freeConds;          // free slots in conditions
 
 void P1CondInit(void) {
     CHECKKERNEL();
@@ -272,65 +475,54 @@ void P1CondInit(void) {
     for (int i = 0; i < P1_MAXCONDS; i++) {
         conditions[i].inuse = FALSE;
     }
+    P1BitmapInit(&freeConds, P1_MAXCONDS);
+    P1NameIndexInit(&condNames);
 }
 
 // creates new condition variable for lock lid named name and returns a unique id
 // for it in *vid. assume max P1_MAXCONDS condition variables, id must be in rage 0-MAXCOND
 int P1_CondCreate(char *name, int lid, int *vid) {
     int result = P1_SUCCESS;
-    int i;
     int condId = -1;
-    LockQ *CondQueue; 
     CHECKKERNEL();
     
     // more code here
     int interruptVal = P1DisableInterrupts();
-    if(interruptVal);
     // error checks
     if(NULL == name){
-        P1EnableInterrupts();
+        if(interruptVal) P1EnableInterrupts();
         return P1_NAME_IS_NULL;
     }
-    if(strlen(name) > P1_MAXNAME){
-        P1EnableInterrupts();
+    if(strlen(name) >= P1_MAXNAME){
+        if(interruptVal) P1EnableInterrupts();
         return P1_NAME_TOO_LONG;
     }
-    // NOTE original -> locks[lid].inuse == 0
-    if(lid >= P1_MAXLOCKS || lid < 0){
-        P1EnableInterrupts();
-        //printf("invalid lock P1cond create\n");
+    if(lid >= P1_MAXLOCKS || lid < 0 || locks[lid].inuse == 0){
+        if(interruptVal) P1EnableInterrupts();
         return P1_INVALID_LOCK;
     }
 
-    for(i = 0; i < P1_MAXCONDS; i++){
-        if(strcmp(name, conditions[i].name) == 0){
-            P1EnableInterrupts();
-            return P1_DUPLICATE_NAME;
-        }
-    }
-    // find open condition
-    for(i = 0; i < P1_MAXCONDS; i++){
-        if(!conditions[i].inuse){
-            condId = i;
-            break;
-        }
+    if(P1NameIndexFind(&condNames, name) != -1){
+        if(interruptVal) P1EnableInterrupts();
+        return P1_DUPLICATE_NAME;
     }
+    // grab the lowest open condition
+    condId = P1BitmapAlloc(&freeConds);
     if(condId == -1){
+        if(interruptVal) P1EnableInterrupts();
         return P1_TOO_MANY_CONDS;
     }
     // set condition fields
-    vid = &condId;
-    locks[lid].vid = condId;
+    *vid = condId;
+    locks[lid].numConds++;
     conditions[condId].lid = lid;
     conditions[condId].inuse = 1;
     strcpy(conditions[condId].name, name);
+    P1NameIndexInsert(&condNames, conditions[condId].name, condId);
     conditions[condId].numWaiting = 0;
-    CondQueue = malloc(sizeof(LockQ));
-    conditions[condId].CondQueue = *CondQueue;
-    conditions[condId].CondQueue.next = NULL;
-    conditions[condId].CondQueue.pid = -1;
+    QueueInit(&conditions[condId].CondQueue);
 
-    P1EnableInterrupts();
+    if(interruptVal) P1EnableInterrupts();
     return result;
 }
 
@@ -344,26 +536,27 @@ int P1_CondFree(int vid) {
     CHECKKERNEL();
     // more code here
     int interruptVal = P1DisableInterrupts();
-    if(interruptVal);
     // error checks
-    if(conditions[vid].inuse){
-        P1EnableInterrupts();
+    if(vid < 0 || vid >= P1_MAXCONDS || conditions[vid].inuse == FALSE){
+        if(interruptVal) P1EnableInterrupts();
         return P1_INVALID_COND;
     }
     currentCond = &conditions[vid];
     currentLock = &locks[currentCond->lid];
-    if(NULL != currentCond->CondQueue.next){
-        P1EnableInterrupts();
+    if(!QueueEmpty(&currentCond->CondQueue)){
+        if(interruptVal) P1EnableInterrupts();
         return P1_BLOCKED_PROCESSES;
     }
 
     // reset condition feilds and locks condition variable
+    P1NameIndexRemove(&condNames, currentCond->name);
     strcpy(currentCond->name, "");
     currentCond->inuse = FALSE;
     currentCond->lid = -1;
-    currentLock->vid = -1;
+    currentLock->numConds--;
+    P1BitmapFree(&freeConds, vid);
 
-    P1EnableInterrupts();
+    if(interruptVal) P1EnableInterrupts();
     return result;
 }
 
@@ -382,40 +575,36 @@ int P1_Wait(int vid) {
     int interruptVal = P1DisableInterrupts();
     if(interruptVal);
 
-    if(vid > P1_MAXCONDS || conditions[vid].inuse == FALSE){
+    if(vid < 0 || vid >= P1_MAXCONDS || conditions[vid].inuse == FALSE){
         P1EnableInterrupts();
         return P1_INVALID_COND;
     }
     currentCond = &conditions[vid];
-
-    // lock id bad   (CHANGED FROM FALSE TO TRUE (this lock right?))
-    if(currentCond->lid > P1_MAXLOCKS){
-        P1EnableInterrupts();
-        return P1_INVALID_LOCK;
-    }
-    if(locks[currentCond->lid].state == FREE){
+    if(!HoldsLock(currentCond->lid)){
         P1EnableInterrupts();
         return P1_LOCK_NOT_HELD;
     }
 
     currentCond->numWaiting++;
-    checker = P1_Unlock(currentCond->lid);
-    // do error checks
-
+    locks[currentCond->lid].condWaiters++;
     stateVal = P1SetState(P1_GetPid(), P1_STATE_BLOCKED, currentCond->lid, vid);
     if(stateVal);
 
-    // adds process to queue
-    newNode = malloc(sizeof(LockQ));
-    newNode->pid = P1_GetPid();
-
-    // wedge new node between empty head node and next node
-    newNode->next = currentCond->CondQueue.next;
-    currentCond->CondQueue.next = newNode;
+    // adds process to the tail of the queue
+    newNode = WaitNode();
+    QueueAppend(&currentCond->CondQueue, newNode);
 
+    // unlock only once we're queued, P1_Unlock enables interrupts and an
+    // interrupt handler's P1_NakedSignal must not miss us
+    checker = P1_Unlock(currentCond->lid);
+    if(checker);
     P1Dispatch(FALSE);
-    lockVal = P1_Lock(currentCond->lid);
-    if(lockVal);
+    // P1_Signal and P1_Broadcast move us onto the lock's queue, so we come back
+    // holding it; P1_NakedSignal only wakes us
+    if(!HoldsLock(currentCond->lid)){
+        lockVal = P1_Lock(currentCond->lid);
+        if(lockVal);
+    }
     P1EnableInterrupts();
     return result;
 }
@@ -423,17 +612,28 @@ int P1_Wait(int vid) {
 // This function signals a process that is waiting on the condition
 // variable. If there are no process waiting on the condition variable,
 // P1_Signal does nothing.
+// Moves the longest waiter on cond straight onto the queue of cond's lock, which
+// the caller holds. The waiter stays blocked until P1_Unlock hands it the lock,
+// rather than waking only to block again on the lock in P1_Wait.
+static void MoveWaiter(Condition *cond){
+    int pid = QueuePop(&cond->CondQueue);
+    int stateVal;
+
+    cond->numWaiting--;
+    locks[cond->lid].condWaiters--;
+    stateVal = P1SetBlockedOn(pid, cond->lid, -1);
+    assert(stateVal == P1_SUCCESS);
+    LockEnqueue(cond->lid, pid);
+}
+
 int P1_Signal(int vid) {
     int result = P1_SUCCESS;
     Condition *currentCond;
-    LockQ *curr;
-    LockQ *prev;
-    int stateVal;
     int interruptVal;
     CHECKKERNEL();
     interruptVal = P1DisableInterrupts();
     if(interruptVal);
-    if(vid > P1_MAXCONDS || conditions[vid].inuse == FALSE){
+    if(vid < 0 || vid >= P1_MAXCONDS || conditions[vid].inuse == FALSE){
         P1EnableInterrupts();
         return P1_INVALID_COND;
     }
@@ -442,28 +642,12 @@ int P1_Signal(int vid) {
         P1EnableInterrupts();
         return P1_INVALID_LOCK;
     }
-    if(P1_GetPid() != locks[currentCond->lid].pid){
+    if(!HoldsLock(currentCond->lid)){
         P1EnableInterrupts();
         return P1_LOCK_NOT_HELD;
     }
-
-    curr = &currentCond->CondQueue;  
-    while(NULL != curr->next){
-            printf("elQueue = %d\n",curr->pid);
-            curr = curr->next;
-    }
     if(currentCond->numWaiting > 0){
-        curr = currentCond->CondQueue.next;
-        prev = &currentCond->CondQueue;
-        while(NULL != curr->next){
-            prev = curr;
-            curr = curr->next;
-        }
-        prev->next = NULL;
-        stateVal = P1SetState(curr->pid, P1_STATE_READY, currentCond->lid, vid);
-        if(stateVal);
-        currentCond->numWaiting--;
-        P1Dispatch(FALSE);
+        MoveWaiter(currentCond);
     }
     P1EnableInterrupts();
     return result;
@@ -475,14 +659,11 @@ int P1_Signal(int vid) {
 int P1_Broadcast(int vid) {
     int result = P1_SUCCESS;
     Condition *currentCond;
-    LockQ *curr;
-    LockQ *head;
-    int stateVal;
     int interruptVal;
     CHECKKERNEL();
     interruptVal = P1DisableInterrupts();
     if(interruptVal);
-    if(vid > P1_MAXCONDS || conditions[vid].inuse == FALSE){
+    if(vid < 0 || vid >= P1_MAXCONDS || conditions[vid].inuse == FALSE){
         P1EnableInterrupts();
         return P1_INVALID_COND;
     }
@@ -491,19 +672,12 @@ int P1_Broadcast(int vid) {
         P1EnableInterrupts();
         return P1_INVALID_LOCK;
     }
-    if(P1_GetPid() != locks[currentCond->lid].pid){
+    if(!HoldsLock(currentCond->lid)){
         P1EnableInterrupts();
         return P1_LOCK_NOT_HELD;
     }
     while(currentCond->numWaiting > 0){
-        head = &currentCond->CondQueue;
-        curr = head->next; 
-        stateVal = P1SetState(curr->pid, P1_STATE_READY, currentCond->lid, vid);
-        if(stateVal);
-        head->next = curr->next;
-        free(curr);
-        currentCond->numWaiting--;
-        P1Dispatch(FALSE);
+        MoveWaiter(currentCond);
     }
     P1EnableInterrupts();
     return result;
@@ -515,31 +689,27 @@ int P1_Broadcast(int vid) {
 int P1_NakedSignal(int vid) {
     int result = P1_SUCCESS;
     Condition *currentCond;
-    LockQ *curr;
-    LockQ prev;
     int stateVal;
+    int interruptVal;
     CHECKKERNEL();
+    interruptVal = P1DisableInterrupts();
 
-    if(vid > P1_MAXCONDS || conditions[vid].inuse == FALSE){
-        P1EnableInterrupts();
+    if(vid < 0 || vid >= P1_MAXCONDS || conditions[vid].inuse == FALSE){
+        if(interruptVal) P1EnableInterrupts();
         return P1_INVALID_COND;
     }
-    // more code here
     currentCond = &conditions[vid];
     if(currentCond->numWaiting > 0){
-        prev = currentCond->CondQueue;
-        curr = prev.next;
-        while(NULL != curr->next){
-            prev = *curr;
-            curr = curr->next;
-        }
+        // wake the process that has waited longest
+        stateVal = P1SetState(QueuePop(&currentCond->CondQueue), P1_STATE_READY,
+                              currentCond->lid, vid);
+        if(stateVal);
         currentCond->numWaiting--;
-        prev.next = NULL;
-        stateVal = P1SetState(curr->pid, P1_STATE_READY, currentCond->lid, vid);
-        free((int*)curr->pid);
-        free(curr->next);
+        locks[currentCond->lid].condWaiters--;
+        // from an interrupt handler this is deferred to P1InterruptExit
         P1Dispatch(FALSE);
     }
+    if(interruptVal) P1EnableInterrupts();
     return result;
 }
 
@@ -551,11 +721,11 @@ int P1_CondName(int vid, char *name, int len) {
     int i;
 
     CHECKKERNEL();
-    if(vid < 0 || vid >= P1_MAXCONDS){
+    if(vid < 0 || vid >= P1_MAXCONDS || conditions[vid].inuse == FALSE){
         return P1_INVALID_COND;
     }
     currentCond = &conditions[vid];
-    if(NULL == currentCond->name){
+    if(NULL == name){
         return P1_NAME_IS_NULL;
     }
 
@@ -567,3 +737,24 @@ int P1_CondName(int vid, char *name, int len) {
     }
     return result;
 }
+
+// Looks up the condition variable named name and returns its id in *vid
+int P1_CondFind(char *name, int *vid) {
+    int result = P1_SUCCESS;
+    int condId;
+    int interruptVal;
+
+    CHECKKERNEL();
+    if(NULL == name){
+        return P1_NAME_IS_NULL;
+    }
+    interruptVal = P1DisableInterrupts();
+    condId = P1NameIndexFind(&condNames, name);
+    if(condId == -1){
+        result = P1_INVALID_COND;
+    } else {
+        *vid = condId;
+    }
+    if(interruptVal) P1EnableInterrupts();
+    return result;
+}
@@ -0,0 +1,154 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests two conditions, notEmpty and notFull, on one lock with a bounded buffer.
+ * Each side should only ever be woken by the other, so neither sees a wakeup with
+ * nothing to do. The lock can't be freed while a process waits on one of its
+ * conditions, and a process waiting for the lock itself isn't on a condition.
+ */
+
+#define CAPACITY 2
+#define ITEMS 20
+
+static int lid, notEmpty, notFull;
+static int buffer[CAPACITY];
+static int head, count;
+static int spurious;
+
+static int
+Producer(void *arg)
+{
+    int rc;
+
+    for (int i = 0; i < ITEMS; i++) {
+        rc = P1_Lock(lid);
+        TEST(rc, P1_SUCCESS);
+        while (count == CAPACITY) {
+            rc = P1_Wait(notFull);
+            TEST(rc, P1_SUCCESS);
+            if (count == CAPACITY) {
+                spurious++;
+            }
+        }
+        buffer[(head + count) % CAPACITY] = i;
+        count++;
+        rc = P1_Signal(notEmpty);
+        TEST(rc, P1_SUCCESS);
+        rc = P1_Unlock(lid);
+        TEST(rc, P1_SUCCESS);
+    }
+    return 0;
+}
+
+static int
+Consumer(void *arg)
+{
+    int rc;
+
+    for (int i = 0; i < ITEMS; i++) {
+        rc = P1_Lock(lid);
+        TEST(rc, P1_SUCCESS);
+        while (count == 0) {
+            rc = P1_Wait(notEmpty);
+            TEST(rc, P1_SUCCESS);
+            if (count == 0) {
+                spurious++;
+            }
+        }
+        TEST(buffer[head], i);
+        head = (head + 1) % CAPACITY;
+        count--;
+        rc = P1_Signal(notFull);
+        TEST(rc, P1_SUCCESS);
+        rc = P1_Unlock(lid);
+        TEST(rc, P1_SUCCESS);
+    }
+    return 0;
+}
+
+static int
+Locker(void *arg)
+{
+    int rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    return 0;
+}
+
+int
+Init(void *arg)
+{
+    int producer, pid, rc;
+    P1_ProcInfo info;
+
+    // the producer fills the buffer and waits for room
+    rc = P1_Fork("Producer", Producer, NULL, USLOSS_MIN_STACK, 3, &producer);
+    TEST(rc, P1_SUCCESS);
+    TEST(count, CAPACITY);
+    rc = P1_GetProcInfo(producer, &info);
+    TEST(rc, P1_SUCCESS);
+    TEST(info.state, P1_STATE_BLOCKED);
+    TEST(info.lid, lid);
+    TEST(info.vid, notFull);
+    rc = P1_LockFree(lid);
+    TEST(rc, P1_BLOCKED_PROCESSES);
+
+    rc = P1_Fork("Consumer", Consumer, NULL, USLOSS_MIN_STACK, 3, &pid);
+    TEST(rc, P1_SUCCESS);
+    TEST(count, 0);
+    TEST(spurious, 0);
+
+    // Locker waits for the lock itself, not a condition
+    rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Fork("Locker", Locker, NULL, USLOSS_MIN_STACK, 3, &pid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_GetProcInfo(pid, &info);
+    TEST(rc, P1_SUCCESS);
+    TEST(info.state, P1_STATE_BLOCKED);
+    TEST(info.lid, lid);
+    TEST(info.vid, -1);
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    // the conditions still use the lock
+    rc = P1_LockFree(lid);
+    TEST(rc, P1_LOCK_HELD);
+    rc = P1_CondFree(notEmpty);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockFree(lid);
+    TEST(rc, P1_LOCK_HELD);
+    rc = P1_CondFree(notFull);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockFree(lid);
+    TEST(rc, P1_SUCCESS);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+
+    P1CondInit();
+    rc = P1_LockCreate("lock", &lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_CondCreate("notEmpty", lid, &notEmpty);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_CondCreate("notFull", lid, &notFull);
+    TEST(rc, P1_SUCCESS);
+
+    rc = P1_Fork("Init", Init, NULL, USLOSS_MIN_STACK, 6, &pid);
+    assert(rc == P1_SUCCESS);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -0,0 +1,86 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests the priority a lock passes on when P1_Unlock hands it to the next waiter.
+ * Main holds the lock while waiters at priorities 4, 3 and 2 queue for it in that
+ * order. Each waiter that gets the lock should inherit priority 2 from the waiter
+ * still queued behind it, and drop back to its own priority when it unlocks.
+ */
+
+static int lid;
+static int held[3];
+static int after[3];
+static int numRun;
+
+static int
+Waiter(void *arg)
+{
+    int i;
+    int rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    i = numRun++;
+    held[i] = P1GetPriority(P1_GetPid());
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    after[i] = P1GetPriority(P1_GetPid());
+    return 0;
+}
+
+static int
+Main(void *arg)
+{
+    int pid, rc;
+
+    rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    for (int priority = 4; priority >= 2; priority--) {
+        rc = P1_Fork(MakeName("Waiter", priority), Waiter, NULL, USLOSS_MIN_STACK,
+                     priority, &pid);
+        TEST(rc, P1_SUCCESS);
+        TEST(P1GetPriority(P1_GetPid()), priority);
+    }
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    TEST(P1GetPriority(P1_GetPid()), 5);
+    TEST(numRun, 3);
+    for (int i = 0; i < 3; i++) {
+        TEST(held[i], 2);
+        TEST(after[i], 4 - i);
+    }
+    PASSED();
+    return 0;
+}
+
+int
+Init(void *arg)
+{
+    int pid;
+    int rc = P1_Fork("Main", Main, NULL, USLOSS_MIN_STACK, 5, &pid);
+    assert(rc == P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+
+    P1LockInit();
+    rc = P1_LockCreate("lock", &lid);
+    TEST(rc, P1_SUCCESS);
+
+    rc = P1_Fork("Init", Init, NULL, USLOSS_MIN_STACK, 6, &pid);
+    assert(rc == P1_SUCCESS);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
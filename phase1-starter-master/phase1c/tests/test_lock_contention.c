@@ -0,0 +1,116 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Lock contention benchmark. Two workers at the same priority yield while holding
+ * the lock, so every acquire blocks and every release wakes the other worker. The
+ * test is compiled together with phase1c.c so it can check the wait queue: a
+ * blocked worker is queued on its slot's preallocated node, so blocking doesn't
+ * allocate, and the queue and its per-priority waiter counts are empty at the end.
+ * Run it under valgrind (make valgrind) for a full leak check.
+ */
+
+#include "../phase1c.c"
+
+#ifndef ITERATIONS
+#define ITERATIONS 1000
+#endif
+
+static int lock;
+static int counter;
+static int blocked;
+
+// returns the total of lock lid's per-priority waiter counts
+static int
+Waiters(int lid)
+{
+    int total = 0;
+
+    for (int i = 0; i < PRIORITIES; i++) {
+        total += locks[lid].waiters[i];
+    }
+    return total;
+}
+
+static int
+Worker(void *arg)
+{
+    int rc;
+    LockQ *head;
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        rc = P1_Lock(lock);
+        TEST(rc, P1_SUCCESS);
+        P1Dispatch(TRUE);
+        // the other worker is blocked unless it has finished
+        head = locks[lock].ElQueue.head;
+        if (head != NULL) {
+            TEST(head == &waitNodes[P1PidSlot(head->pid)], 1);
+            TEST(head->next, NULL);
+            TEST(Waiters(lock), 1);
+            blocked++;
+        }
+        counter++;
+        rc = P1_Unlock(lock);
+        TEST(rc, P1_SUCCESS);
+        P1Dispatch(TRUE);
+    }
+    return 0;
+}
+
+static int
+Starter(void *arg)
+{
+    int pid, rc;
+
+    rc = P1_Fork("Worker1", Worker, NULL, USLOSS_MIN_STACK, 3, &pid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Fork("Worker2", Worker, NULL, USLOSS_MIN_STACK, 3, &pid);
+    TEST(rc, P1_SUCCESS);
+    return 0;
+}
+
+int
+Init(void *arg) 
+{
+    int pid, rc;
+    P1_SchedStats stats;
+
+    // runs once both workers have finished
+    rc = P1_Fork("Starter", Starter, NULL, USLOSS_MIN_STACK, 1, &pid);
+    TEST(rc, P1_SUCCESS);
+    TEST(counter, 2 * ITERATIONS);
+    rc = P1_GetSchedStats(-1, &stats);
+    TEST(rc, P1_SUCCESS);
+    // each acquire blocked
+    TEST(stats.voluntary >= 2 * ITERATIONS, 1);
+    TEST(blocked >= 2 * ITERATIONS - 1, 1);
+    TEST(locks[lock].state, FREE);
+    TEST(locks[lock].ElQueue.head, NULL);
+    TEST(locks[lock].ElQueue.tail, NULL);
+    TEST(Waiters(lock), 0);
+    PASSED();
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+
+    P1LockInit();
+    rc = P1_LockCreate("lock", &lock);
+    TEST(rc, P1_SUCCESS);
+
+    rc = P1_Fork("Init", Init, NULL, USLOSS_MIN_STACK, 6, &pid);
+    assert(rc == P1_SUCCESS);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -0,0 +1,117 @@
+/*
+ * Tests priority inheritance through a chain of locks. Low holds lock 2. Middle
+ * holds lock 1 and blocks on lock 2, so Low inherits Middle's priority. High then
+ * blocks on lock 1, so both Middle and, through it, Low inherit High's priority,
+ * and Spinner at an intermediate priority can't run until Low releases lock 2 and
+ * drops back to its own priority. Middle then finishes with the locks and High runs
+ * before Spinner.
+ */
+
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include "tester.h"
+
+#define HIGH_PRIORITY       1
+#define SPINNER_PRIORITY    2
+#define MIDDLE_PRIORITY     4
+#define LOW_PRIORITY        5
+
+static int lock1, lock2;
+static char order[3];
+static int numRan = 0;
+
+int High(void *arg)
+{
+    int rc = P1_Lock(lock1);
+    TEST(rc, P1_SUCCESS);
+    order[numRan++] = 'H';
+    rc = P1_Unlock(lock1);
+    TEST(rc, P1_SUCCESS);
+    return 0;
+}
+
+int Spinner(void *arg)
+{
+    order[numRan++] = 'S';
+    return 0;
+}
+
+int Middle(void *arg)
+{
+    int rc = P1_Lock(lock1);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Lock(lock2);
+    TEST(rc, P1_SUCCESS);
+    // still inheriting from High through lock 1
+    TEST(P1GetPriority(P1_GetPid()), HIGH_PRIORITY);
+    rc = P1_Unlock(lock2);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Unlock(lock1);
+    TEST(rc, P1_SUCCESS);
+    order[numRan++] = 'M';
+    return 0;
+}
+
+int Low(void *arg)
+{
+    int pid, middle;
+    int rc = P1_Lock(lock2);
+    TEST(rc, P1_SUCCESS);
+
+    rc = P1_Fork("Middle", Middle, NULL, USLOSS_MIN_STACK, MIDDLE_PRIORITY, &middle);
+    TEST(rc, P1_SUCCESS);
+    TEST(P1GetPriority(P1_GetPid()), MIDDLE_PRIORITY);
+
+    rc = P1_Fork("High", High, NULL, USLOSS_MIN_STACK, HIGH_PRIORITY, &pid);
+    TEST(rc, P1_SUCCESS);
+    TEST(P1GetPriority(middle), HIGH_PRIORITY);
+    TEST(P1GetPriority(P1_GetPid()), HIGH_PRIORITY);
+
+    rc = P1_Fork("Spinner", Spinner, NULL, USLOSS_MIN_STACK, SPINNER_PRIORITY, &pid);
+    TEST(rc, P1_SUCCESS);
+    TEST(numRan, 0);
+
+    rc = P1_Unlock(lock2);
+    TEST(rc, P1_SUCCESS);
+    TEST(numRan, 3);
+    TEST(order[0], 'H');
+    TEST(order[1], 'S');
+    TEST(order[2], 'M');
+    TEST(P1GetPriority(P1_GetPid()), LOW_PRIORITY);
+    PASSED();
+    return 0;
+}
+
+int
+Init(void *arg) 
+{
+    int pid;
+    int rc = P1_Fork("Low", Low, NULL, USLOSS_MIN_STACK, LOW_PRIORITY, &pid);
+    assert(rc == P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+
+    P1LockInit();
+    rc = P1_LockCreate("lock1", &lock1);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockCreate("lock2", &lock2);
+    TEST(rc, P1_SUCCESS);
+
+    rc = P1_Fork("Init", Init, NULL, USLOSS_MIN_STACK, 6, &pid);
+    assert(rc == P1_SUCCESS);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
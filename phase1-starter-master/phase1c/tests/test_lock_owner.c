@@ -0,0 +1,100 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests that only the process holding a lock can unlock it or use its condition,
+ * and that a held lock can't be freed. Creating a lock doesn't make the creator
+ * its holder.
+ */
+
+static int lid, other, vid;
+static int ran;
+
+static int
+NotHolder(void *arg)
+{
+    int rc = P1_Unlock(lid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    rc = P1_Wait(vid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    rc = P1_Signal(vid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    rc = P1_Broadcast(vid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    ran = TRUE;
+    return 0;
+}
+
+static int
+Main(void *arg)
+{
+    int pid, rc;
+
+    // neither lock has been acquired
+    rc = P1_LockCreate("lock", &lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockCreate("other", &other);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    rc = P1_Unlock(other);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    rc = P1_CondCreate("cond", lid, &vid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Wait(vid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    rc = P1_Signal(vid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    rc = P1_Broadcast(vid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+
+    rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockFree(lid);
+    TEST(rc, P1_LOCK_HELD);
+    rc = P1_Fork("NotHolder", NotHolder, NULL, USLOSS_MIN_STACK, 1, &pid);
+    TEST(rc, P1_SUCCESS);
+    TEST(ran, TRUE);
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    rc = P1_CondFree(vid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockFree(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockFree(other);
+    TEST(rc, P1_SUCCESS);
+    PASSED();
+    return 0;
+}
+
+int
+Init(void *arg)
+{
+    int pid;
+    int rc = P1_Fork("Main", Main, NULL, USLOSS_MIN_STACK, 2, &pid);
+    assert(rc == P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+
+    P1CondInit();
+    rc = P1_Fork("Init", Init, NULL, USLOSS_MIN_STACK, 6, &pid);
+    assert(rc == P1_SUCCESS);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -0,0 +1,122 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests a process that quits holding a lock. Holder quits while Waiter, which
+ * it forked at a higher priority, is blocked on the lock, so the lock passes to
+ * Waiter. The next process forked into Holder's slot starts holding no locks and
+ * inheriting no priority.
+ */
+
+static int lid, other;
+static int ran;
+
+static int
+Waiter(void *arg)
+{
+    int rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    ran = TRUE;
+    return 0;
+}
+
+static int
+Holder(void *arg)
+{
+    int pid;
+    int rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Fork("Waiter", Waiter, NULL, USLOSS_MIN_STACK, 1, &pid);
+    TEST(rc, P1_SUCCESS);
+    TEST(P1GetPriority(P1_GetPid()), 1);
+    // quit still holding lid
+    return 42;
+}
+
+static int
+Reuse(void *arg)
+{
+    int rc = P1_Unlock(lid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+    rc = P1_Lock(other);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Unlock(other);
+    TEST(rc, P1_SUCCESS);
+    TEST(P1GetPriority(P1_GetPid()), 2);
+    ran = TRUE;
+    return 0;
+}
+
+static int
+Main(void *arg)
+{
+    int holder, pid, status, rc;
+
+    rc = P1_LockCreate("lock", &lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockCreate("other", &other);
+    TEST(rc, P1_SUCCESS);
+
+    // Holder and Waiter outrank us, so both have quit when P1_Fork returns
+    rc = P1_Fork("Holder", Holder, NULL, USLOSS_MIN_STACK, 2, &holder);
+    TEST(rc, P1_SUCCESS);
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(pid, holder);
+    TEST(status, 42);
+    TEST(ran, TRUE);
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_LOCK_NOT_HELD);
+
+    // Holder's slot is the lowest free one
+    ran = FALSE;
+    rc = P1_Fork("Reuse", Reuse, NULL, USLOSS_MIN_STACK, 2, &pid);
+    TEST(rc, P1_SUCCESS);
+    TEST(P1PidSlot(pid), P1PidSlot(holder));
+    rc = P1GetChildStatus(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(ran, TRUE);
+
+    rc = P1_LockFree(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockFree(other);
+    TEST(rc, P1_SUCCESS);
+    PASSED();
+    return 0;
+}
+
+int
+Init(void *arg)
+{
+    int pid;
+    int rc = P1_Fork("Main", Main, NULL, USLOSS_MIN_STACK, 3, &pid);
+    assert(rc == P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+
+    P1LockInit();
+    rc = P1_Fork("Init", Init, NULL, USLOSS_MIN_STACK, 6, &pid);
+    assert(rc == P1_SUCCESS);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -0,0 +1,72 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests the lock and condition name index with a full table. Every other lock is
+ * freed, which must leave the rest findable, and the freed names can be reused.
+ */
+
+static int lids[P1_MAXLOCKS];
+
+void
+startup(int argc, char **argv)
+{
+    int lid, vid, rc;
+
+    P1CondInit();
+    for (int i = 0; i < P1_MAXLOCKS; i++) {
+        rc = P1_LockCreate(MakeName("lock", i), &lids[i]);
+        TEST(rc, P1_SUCCESS);
+    }
+    rc = P1_LockCreate("lock7", &lid);
+    TEST(rc, P1_DUPLICATE_NAME);
+    rc = P1_LockCreate("another", &lid);
+    TEST(rc, P1_TOO_MANY_LOCKS);
+    for (int i = 0; i < P1_MAXLOCKS; i++) {
+        rc = P1_LockFind(MakeName("lock", i), &lid);
+        TEST(rc, P1_SUCCESS);
+        TEST(lid, lids[i]);
+    }
+
+    for (int i = 0; i < P1_MAXLOCKS; i += 2) {
+        rc = P1_LockFree(lids[i]);
+        TEST(rc, P1_SUCCESS);
+    }
+    for (int i = 0; i < P1_MAXLOCKS; i++) {
+        rc = P1_LockFind(MakeName("lock", i), &lid);
+        if (i % 2) {
+            TEST(rc, P1_SUCCESS);
+            TEST(lid, lids[i]);
+        } else {
+            TEST(rc, P1_INVALID_LOCK);
+        }
+    }
+    rc = P1_LockCreate("lock8", &lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockFind("lock8", &lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_LockFind(NULL, &lid);
+    TEST(rc, P1_NAME_IS_NULL);
+
+    // conditions have their own names
+    rc = P1_CondCreate("lock1", lids[1], &vid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_CondCreate("lock1", lids[3], &vid);
+    TEST(rc, P1_DUPLICATE_NAME);
+    rc = P1_CondFind("lock1", &lid);
+    TEST(rc, P1_SUCCESS);
+    TEST(lid, vid);
+    rc = P1_CondFree(vid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_CondFind("lock1", &lid);
+    TEST(rc, P1_INVALID_COND);
+    PASSED();
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -0,0 +1,116 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests that lock and condition wait queues are FIFO. The waiters outrank Main, so
+ * each blocks right after it is forked, in fork order. They should then get the lock
+ * in that order when Main unlocks it, and again when Main signals the condition
+ * once per waiter.
+ */
+
+#define WAITERS 5
+
+static int lid, vid;
+static int order[WAITERS];
+static int numRun;
+
+static int
+LockWaiter(void *arg)
+{
+    int rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    order[numRun++] = (int) arg;
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    return 0;
+}
+
+static int
+CondWaiter(void *arg)
+{
+    int rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Wait(vid);
+    TEST(rc, P1_SUCCESS);
+    order[numRun++] = (int) arg;
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    return 0;
+}
+
+static int
+Main(void *arg)
+{
+    int pid, rc;
+
+    rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    for (int i = 0; i < WAITERS; i++) {
+        rc = P1_Fork(MakeName("LockWaiter", i), LockWaiter, (void *) i, USLOSS_MIN_STACK, 1, &pid);
+        TEST(rc, P1_SUCCESS);
+        // once we inherit the first waiter's priority the rest don't preempt us
+        P1Dispatch(TRUE);
+    }
+    TEST(numRun, 0);
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    TEST(numRun, WAITERS);
+    for (int i = 0; i < WAITERS; i++) {
+        TEST(order[i], i);
+    }
+
+    numRun = 0;
+    for (int i = 0; i < WAITERS; i++) {
+        rc = P1_Fork(MakeName("CondWaiter", i), CondWaiter, (void *) i, USLOSS_MIN_STACK, 1, &pid);
+        TEST(rc, P1_SUCCESS);
+    }
+    for (int i = 0; i < WAITERS; i++) {
+        rc = P1_Lock(lid);
+        TEST(rc, P1_SUCCESS);
+        rc = P1_Signal(vid);
+        TEST(rc, P1_SUCCESS);
+        rc = P1_Unlock(lid);
+        TEST(rc, P1_SUCCESS);
+        TEST(numRun, i + 1);
+    }
+    for (int i = 0; i < WAITERS; i++) {
+        TEST(order[i], i);
+    }
+    PASSED();
+    return 0;
+}
+
+int
+Init(void *arg)
+{
+    int pid;
+    int rc = P1_Fork("Main", Main, NULL, USLOSS_MIN_STACK, 2, &pid);
+    assert(rc == P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+
+    P1CondInit();
+    rc = P1_LockCreate("lock", &lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_CondCreate("cond", lid, &vid);
+    TEST(rc, P1_SUCCESS);
+
+    rc = P1_Fork("Init", Init, NULL, USLOSS_MIN_STACK, 6, &pid);
+    assert(rc == P1_SUCCESS);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
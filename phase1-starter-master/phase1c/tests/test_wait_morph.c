@@ -0,0 +1,111 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests that P1_Broadcast moves the waiters onto the lock's queue instead of waking
+ * them. The waiters outrank Main, so each takes the lock and waits on the condition
+ * right after it is forked. Main's broadcast should not switch to any of them; they
+ * should stay blocked on the lock and then get it one at a time, in order, without
+ * blocking a second time.
+ */
+
+#define WAITERS 5
+
+static int lid, vid;
+static int order[WAITERS];
+static int blocks[WAITERS];
+static int numRun;
+
+static int
+Waiter(void *arg)
+{
+    P1_SchedStats stats;
+    int rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Wait(vid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_GetSchedStats(P1_GetPid(), &stats);
+    TEST(rc, P1_SUCCESS);
+    order[numRun] = (int) arg;
+    blocks[numRun++] = stats.voluntary;
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    return 0;
+}
+
+static int
+Main(void *arg)
+{
+    int pids[WAITERS];
+    int rc;
+    P1_SchedStats before, after;
+    P1_ProcInfo info;
+
+    for (int i = 0; i < WAITERS; i++) {
+        rc = P1_Fork(MakeName("Waiter", i), Waiter, (void *) i, USLOSS_MIN_STACK, 1, &pids[i]);
+        TEST(rc, P1_SUCCESS);
+    }
+    rc = P1_Lock(lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_GetSchedStats(P1_GetPid(), &before);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Broadcast(vid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_GetSchedStats(P1_GetPid(), &after);
+    TEST(rc, P1_SUCCESS);
+    TEST(after.voluntary, before.voluntary);
+    TEST(after.involuntary, before.involuntary);
+    TEST(numRun, 0);
+    for (int i = 0; i < WAITERS; i++) {
+        rc = P1_GetProcInfo(pids[i], &info);
+        TEST(rc, P1_SUCCESS);
+        TEST(info.state, P1_STATE_BLOCKED);
+        TEST(info.lid, lid);
+        TEST(info.vid, -1);
+    }
+    rc = P1_Unlock(lid);
+    TEST(rc, P1_SUCCESS);
+    TEST(numRun, WAITERS);
+    for (int i = 0; i < WAITERS; i++) {
+        TEST(order[i], i);
+        // only in P1_Wait, never again for the lock
+        TEST(blocks[i], 1);
+    }
+    PASSED();
+    return 0;
+}
+
+int
+Init(void *arg)
+{
+    int pid;
+    int rc = P1_Fork("Main", Main, NULL, USLOSS_MIN_STACK, 2, &pid);
+    assert(rc == P1_SUCCESS);
+    // should not return
+    FAILED(1,0);
+    return 0;
+}
+
+void
+startup(int argc, char **argv)
+{
+    int pid;
+    int rc;
+
+    P1CondInit();
+    rc = P1_LockCreate("lock", &lid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_CondCreate("cond", lid, &vid);
+    TEST(rc, P1_SUCCESS);
+
+    rc = P1_Fork("Init", Init, NULL, USLOSS_MIN_STACK, 6, &pid);
+    assert(rc == P1_SUCCESS);
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
+
+void finish(int argc, char **argv) {}
@@ -7,24 +7,66 @@
 #include <phase1.h>
 #include <phase1Int.h>
 
+#define CHECKKERNEL() \
+    if ((USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) == 0) USLOSS_IllegalInstruction()
+
 static void DeviceHandler(int type, void *arg);
 static void SyscallHandler(int type, void *arg);
 static void IllegalInstructionHandler(int type, void *arg);
 
 static int sentinel(void *arg);
 
+// a process waiting in P1_DeviceWait blocks on its unit's condition until the
+// interrupt handler records a status for it or P1_DeviceAbort cancels the wait
+typedef struct Device {
+    int     lid;
+    int     vid;
+    int     status;         // status from the last interrupt
+    int     pending;        // TRUE if status hasn't been consumed by P1_DeviceWait
+    int     abortSeq;       // bumped by P1_DeviceAbort
+    int     waiting;        // number of processes in P1_DeviceWait
+} Device;
+
+#define CLOCK_WAKEUP 5      // clock ticks between wakeups of clock waiters
+
+static const int units[] = {USLOSS_CLOCK_UNITS, USLOSS_ALARM_UNITS, USLOSS_DISK_UNITS,
+                            USLOSS_TERM_UNITS};
+static Device devices[USLOSS_TERM_DEV + 1][USLOSS_TERM_UNITS];
+
+static int CheckDevice(int type, int unit);
+static void WakeupDevice(int type, int unit, int status);
+
 void 
 startup(int argc, char **argv)
 {
     int pid;
+    int rc;
+    char name[P1_MAXNAME];
     P1CondInit();
 
     // initialize device data structures
+    for (int type = 0; type <= USLOSS_TERM_DEV; type++) {
+        for (int unit = 0; unit < units[type]; unit++) {
+            Device *dev = &devices[type][unit];
+            snprintf(name, sizeof(name), "dev%d.%d", type, unit);
+            rc = P1_LockCreate(name, &dev->lid);
+            assert(rc == P1_SUCCESS);
+            rc = P1_CondCreate(name, dev->lid, &dev->vid);
+            assert(rc == P1_SUCCESS);
+            dev->pending = FALSE;
+            dev->abortSeq = 0;
+            dev->waiting = 0;
+        }
+    }
     // put device interrupt handlers into interrupt vector
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = DeviceHandler;
+    USLOSS_IntVec[USLOSS_ALARM_INT] = DeviceHandler;
+    USLOSS_IntVec[USLOSS_DISK_INT] = DeviceHandler;
+    USLOSS_IntVec[USLOSS_TERM_INT] = DeviceHandler;
     USLOSS_IntVec[USLOSS_SYSCALL_INT] = SyscallHandler;
 
     /* create the sentinel process */
-    int rc = P1_Fork("sentinel", sentinel, NULL, USLOSS_MIN_STACK, 6 , &pid);
+    rc = P1_Fork("sentinel", sentinel, NULL, USLOSS_MIN_STACK, 6 , &pid);
     assert(rc == P1_SUCCESS);
     // should not return
     assert(0);
@@ -32,27 +74,142 @@ startup(int argc, char **argv)
 
 } /* End of startup */
 
+static int
+CheckDevice(int type, int unit)
+{
+    if ((type < 0) || (type > USLOSS_TERM_DEV)) {
+        return P1_INVALID_TYPE;
+    }
+    if ((unit < 0) || (unit >= units[type])) {
+        return P1_INVALID_UNIT;
+    }
+    return P1_SUCCESS;
+}
+
+/*
+ * Waits for an interrupt from the unit and returns its status in *status. Returns
+ * P1_WAIT_ABORTED if P1_DeviceAbort cancelled the wait.
+ */
 int 
 P1_DeviceWait(int type, int unit, int *status) 
 {
-    int     result = P1_SUCCESS;
-    // disable interrupts
-    // check kernel mode
-    // use condition variable to wait for interrupt
-    // set *status to device's status
-    // restore interrupts
+    int     result;
+    int     enabled;
+    int     rc;
+    int     abortSeq;
+    Device  *dev;
+
+    CHECKKERNEL();
+    result = CheckDevice(type, unit);
+    if (result != P1_SUCCESS) {
+        goto done;
+    }
+    dev = &devices[type][unit];
+    rc = P1_Lock(dev->lid);
+    assert(rc == P1_SUCCESS);
+    // the handler doesn't take the lock, so keep it out while we look at the unit
+    enabled = P1DisableInterrupts();
+    abortSeq = dev->abortSeq;
+    dev->waiting++;
+    while (!dev->pending && (dev->abortSeq == abortSeq)) {
+        rc = P1_Wait(dev->vid);
+        assert(rc == P1_SUCCESS);
+        // P1_Wait returns with interrupts enabled
+        rc = P1DisableInterrupts();
+        assert(rc);
+    }
+    dev->waiting--;
+    if (dev->abortSeq != abortSeq) {
+        result = P1_WAIT_ABORTED;
+    } else {
+        *status = dev->status;
+        dev->pending = FALSE;
+    }
+    rc = P1_Unlock(dev->lid);
+    assert(rc == P1_SUCCESS);
+    if (!enabled) {
+        // P1_Unlock enabled them
+        rc = P1DisableInterrupts();
+    }
+done:
     return result;
 }
 
+/*
+ * Wakes every process waiting on the unit, which return P1_WAIT_ABORTED.
+ */
+int
+P1_DeviceAbort(int type, int unit)
+{
+    int     result;
+    int     rc;
+    Device  *dev;
+
+    CHECKKERNEL();
+    result = CheckDevice(type, unit);
+    if (result != P1_SUCCESS) {
+        goto done;
+    }
+    dev = &devices[type][unit];
+    rc = P1_Lock(dev->lid);
+    assert(rc == P1_SUCCESS);
+    if (dev->waiting > 0) {
+        dev->abortSeq++;
+        rc = P1_Broadcast(dev->vid);
+        assert(rc == P1_SUCCESS);
+    }
+    rc = P1_Unlock(dev->lid);
+    assert(rc == P1_SUCCESS);
+done:
+    return result;
+}
+
+/*
+ * Records the status and wakes a waiter. Called from the interrupt handler, so the
+ * switch to the waiter happens in P1InterruptExit. A clock wakeup nobody is waiting
+ * for isn't kept, or the next P1_DeviceWait on the clock would return at once.
+ */
+static void
+WakeupDevice(int type, int unit, int status)
+{
+    Device  *dev = &devices[type][unit];
+    int     rc;
+
+    dev->status = status;
+    if ((type != USLOSS_CLOCK_DEV) || (dev->waiting > 0)) {
+        dev->pending = TRUE;
+    }
+    rc = P1_NakedSignal(dev->vid);
+    assert(rc == P1_SUCCESS);
+}
+
 
 static void
 DeviceHandler(int type, void *arg) 
 {
-    // if clock device
-    //      P1_WakeupDevice every 5 ticks
-    //      P1Dispatch(TRUE) every 4 ticks
-    // else
-    //      P1_WakeupDevice
+    static int ticks = 0;
+    int     unit;
+    int     status;
+    int     rc;
+
+    // time in the handler is charged as interrupt time, not to the interrupted process
+    P1InterruptEnter();
+    if (type == USLOSS_CLOCK_INT) {
+        ticks++;
+        if ((ticks % CLOCK_WAKEUP) == 0) {
+            rc = USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &status);
+            assert(rc == USLOSS_DEV_OK);
+            WakeupDevice(USLOSS_CLOCK_DEV, 0, status);
+        }
+        // rotate the running process when its quantum is up
+        P1Tick();
+    } else {
+        unit = (int) arg;
+        rc = USLOSS_DeviceInput(type, unit, &status);
+        assert(rc == USLOSS_DEV_OK);
+        WakeupDevice(type, unit, status);
+    }
+    P1InterruptExit();
 }
 
 static int
@@ -60,15 +217,20 @@ sentinel (void *notused)
 {
     int     pid;
     int     rc;
+    int     count;
 
     /* start the P2_Startup process */
     rc = P1_Fork("P2_Startup", P2_Startup, NULL, 4 * USLOSS_MIN_STACK, 1, &pid);
     assert(rc == P1_SUCCESS);
 
-    // enable interrupts
-    // while sentinel has children
-    //      get children that have quit via P1GetChildStatus (either tag)
-    //      wait for an interrupt via USLOSS_WaitInt
+    P1EnableInterrupts();
+    // reap every child that has quit in one pass, then wait for an interrupt
+    while ((rc = P1GetChildStatuses(NULL, NULL, 0, &count)) != P1_NO_CHILDREN) {
+        assert((rc == P1_SUCCESS) || (rc == P1_NO_QUIT));
+        P1Idle(TRUE);
+        USLOSS_WaitInt();
+        P1Idle(FALSE);
+    }
     USLOSS_Console("Sentinel quitting.\n");
     return 0;
 } /* End of sentinel */
@@ -77,17 +239,63 @@ int
 P1_Join(int *pid, int *status) 
 {
     int result = P1_SUCCESS;
-    // disable interrupts
-    // kernel mode
-    // do
-    //     use P1GetChildStatus to get a child that has quit  
-    //     if no children have quit
-    //        set state to P1_STATE_JOINING vi P1SetState
-    //        P1Dispatch(FALSE)
-    // until either a child quit or there are no more children
+    int enabled;
+    int rc;
+
+    CHECKKERNEL();
+    enabled = P1DisableInterrupts();
+    while ((result = P1GetChildStatus(pid, status)) == P1_NO_QUIT) {
+        // P1_Quit makes us READY again when a child quits
+        rc = P1SetState(P1_GetPid(), P1_STATE_JOINING, -1, -1);
+        if (rc == P1_SUCCESS) {
+            P1Dispatch(FALSE);
+        } else {
+            assert(rc == P1_CHILD_QUIT);
+        }
+    }
+    if (enabled) {
+        P1EnableInterrupts();
+    }
     return result;
 }
 
+/*
+ * Waits for child pid to quit and returns its status. Only that child quitting wakes
+ * the caller. Returns P1_INVALID_PID if pid isn't a child of the caller.
+ */
+int
+P1_JoinPid(int pid, int *status)
+{
+    int result;
+    int enabled;
+    int rc;
+
+    CHECKKERNEL();
+    enabled = P1DisableInterrupts();
+    while ((result = P1GetChildStatusPid(pid, status)) == P1_NO_QUIT) {
+        rc = P1SetJoiningPid(pid);
+        if (rc == P1_SUCCESS) {
+            P1Dispatch(FALSE);
+        } else {
+            assert(rc == P1_CHILD_QUIT);
+        }
+    }
+    if (enabled) {
+        P1EnableInterrupts();
+    }
+    return result;
+}
+
+/*
+ * Non-blocking P1_Join. Returns P1_NO_QUIT if no child has quit.
+ */
+int
+P1_TryJoin(int *pid, int *status)
+{
+    CHECKKERNEL();
+    return P1GetChildStatus(pid, status);
+}
+
 static void
 SyscallHandler(int type, void *arg) 
 {
@@ -0,0 +1,122 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests P1_DeviceWait, P1_DeviceAbort, and wake-up preemption. Waiter waits for the
+ * clock while the lower-priority Spinner hogs the CPU. Each wakeup should switch to
+ * Waiter before the clock interrupt returns, so every latency in the histogram is
+ * well under a clock tick; waiting for Spinner's quantum to run out would take at
+ * least a tick. TermWaiter's wait is cancelled by Aborter. A clock wait that
+ * starts after several wakeups nobody waited for still waits for the next one.
+ */
+
+#define WAITS 3
+
+static int
+Waiter(void *arg)
+{
+    int status, rc;
+
+    for (int i = 0; i < WAITS; i++) {
+        rc = P1_DeviceWait(USLOSS_CLOCK_DEV, 0, &status);
+        TEST(rc, P1_SUCCESS);
+    }
+    return 0;
+}
+
+static int
+Clock(void)
+{
+    int now;
+    int rc = USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &now);
+    assert(rc == USLOSS_DEV_OK);
+    return now;
+}
+
+// spins for usec microseconds with interrupts enabled
+static void
+Spin(int usec)
+{
+    int start = Clock();
+
+    while (Clock() - start < usec) {
+        P1EnableInterrupts();
+    }
+}
+
+static int
+Spinner(void *arg)
+{
+    Spin(500000);
+    return 0;
+}
+
+static int
+TermWaiter(void *arg)
+{
+    int status;
+
+    return P1_DeviceWait(USLOSS_TERM_DEV, 1, &status);
+}
+
+static int
+Aborter(void *arg)
+{
+    int rc = P1_DeviceAbort(USLOSS_TERM_DEV, 1);
+    TEST(rc, P1_SUCCESS);
+    return 0;
+}
+
+int
+P2_Startup(void *arg)
+{
+    int waiter, pid, status, start, rc;
+    int buckets[P1_LATENCY_BUCKETS];
+    int total = 0;
+
+    rc = P1_DeviceWait(USLOSS_TERM_DEV + 1, 0, &status);
+    TEST(rc, P1_INVALID_TYPE);
+    rc = P1_DeviceWait(USLOSS_DISK_DEV, USLOSS_DISK_UNITS, &status);
+    TEST(rc, P1_INVALID_UNIT);
+    rc = P1_DeviceAbort(USLOSS_CLOCK_DEV, -1);
+    TEST(rc, P1_INVALID_UNIT);
+
+    // the clock wakes waiters every 100 ms; the status is from after the wait began
+    Spin(300000);
+    start = Clock();
+    rc = P1_DeviceWait(USLOSS_CLOCK_DEV, 0, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(status >= start, 1);
+
+    rc = P1_Fork("Waiter", Waiter, NULL, USLOSS_MIN_STACK, 2, &waiter);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Fork("Spinner", Spinner, NULL, USLOSS_MIN_STACK, 4, &pid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_JoinPid(waiter, &status);
+    TEST(rc, P1_SUCCESS);
+
+    P1GetWakeLatency(buckets);
+    for (int i = 0; i < P1_LATENCY_BUCKETS; i++) {
+        total += buckets[i];
+    }
+    TEST(total, WAITS + 1);
+    // every wakeup took less than 2^13 microseconds, under half a tick
+    TEST(buckets[P1_LATENCY_BUCKETS - 1], 0);
+    TEST(buckets[P1_LATENCY_BUCKETS - 2], 0);
+
+    rc = P1_Fork("TermWaiter", TermWaiter, NULL, USLOSS_MIN_STACK, 2, &waiter);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Fork("Aborter", Aborter, NULL, USLOSS_MIN_STACK, 3, &pid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_JoinPid(waiter, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(status, P1_WAIT_ABORTED);
+    PASSED();
+    return 0;
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
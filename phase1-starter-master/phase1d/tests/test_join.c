@@ -0,0 +1,90 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests P1_Join and P1GetChildStatuses. The children run at P2_Startup's priority so
+ * they don't preempt it; once it joins they all run and quit, and the first join
+ * returns the first child. The rest are drained in bulk, in the order they quit.
+ * Orphan is left behind by Parent, so it is inherited and reaped by the sentinel.
+ */
+
+static int
+Child(void *arg)
+{
+    return (int) arg;
+}
+
+static int
+Parent(void *arg)
+{
+    int pid;
+    int rc = P1_Fork("Orphan", Child, (void *) 99, USLOSS_MIN_STACK, 4, &pid);
+    TEST(rc, P1_SUCCESS);
+    return 7;
+}
+
+int
+P2_Startup(void *arg)
+{
+    int pids[3], cpids[10], statuses[10];
+    int pid, status, count, rc;
+    char name[P1_MAXNAME];
+
+    rc = P1_Join(&pid, &status);
+    TEST(rc, P1_NO_CHILDREN);
+
+    for (int i = 0; i < 3; i++) {
+        snprintf(name, sizeof(name), "Child%d", i);
+        rc = P1_Fork(name, Child, (void *) (10 + i), USLOSS_MIN_STACK, 1, &pids[i]);
+        TEST(rc, P1_SUCCESS);
+    }
+    rc = P1GetChildStatuses(cpids, statuses, 10, &count);
+    TEST(rc, P1_NO_QUIT);
+    TEST(count, 0);
+
+    rc = P1_Join(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(pid, pids[0]);
+    TEST(status, 10);
+
+    rc = P1GetChildStatuses(cpids, statuses, 10, &count);
+    TEST(rc, P1_SUCCESS);
+    TEST(count, 2);
+    TEST(cpids[0], pids[1]);
+    TEST(statuses[0], 11);
+    TEST(cpids[1], pids[2]);
+    TEST(statuses[1], 12);
+
+    // max limits how many are reaped, NULL buffers drain the rest
+    for (int i = 0; i < 3; i++) {
+        snprintf(name, sizeof(name), "Child%d", i);
+        rc = P1_Fork(name, Child, (void *) (20 + i), USLOSS_MIN_STACK, 1, &pids[i]);
+        TEST(rc, P1_SUCCESS);
+    }
+    rc = P1_Join(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(status, 20);
+    rc = P1GetChildStatuses(cpids, statuses, 1, &count);
+    TEST(rc, P1_SUCCESS);
+    TEST(count, 1);
+    TEST(statuses[0], 21);
+    rc = P1GetChildStatuses(NULL, NULL, 0, &count);
+    TEST(rc, P1_SUCCESS);
+    TEST(count, 1);
+
+    rc = P1_Fork("Parent", Parent, NULL, USLOSS_MIN_STACK, 2, &pid);
+    TEST(rc, P1_SUCCESS);
+    rc = P1_Join(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(status, 7);
+    rc = P1_Join(&pid, &status);
+    TEST(rc, P1_NO_CHILDREN);
+    PASSED();
+    return 0;
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
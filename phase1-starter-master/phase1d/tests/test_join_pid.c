@@ -0,0 +1,69 @@
+#include <phase1.h>
+#include <phase1Int.h>
+#include <assert.h>
+#include <tester.h>
+
+/*
+ * Tests P1_JoinPid and P1_TryJoin. The children run at a lower priority than
+ * P2_Startup, so while it waits for the last child the others quit without it
+ * being woken; they are then reaped with P1_TryJoin in the order they quit.
+ */
+
+static int order[3];
+static int numQuit;
+
+static int
+Child(void *arg)
+{
+    order[numQuit++] = P1_GetPid();
+    return (int) arg;
+}
+
+int
+P2_Startup(void *arg)
+{
+    int pids[3];
+    int pid, status, rc;
+    char name[P1_MAXNAME];
+
+    rc = P1_TryJoin(&pid, &status);
+    TEST(rc, P1_NO_CHILDREN);
+    rc = P1_JoinPid(P1_GetPid(), &status);
+    TEST(rc, P1_INVALID_PID);
+
+    for (int i = 0; i < 3; i++) {
+        snprintf(name, sizeof(name), "Child%d", i);
+        rc = P1_Fork(name, Child, (void *) (10 + i), USLOSS_MIN_STACK, 2, &pids[i]);
+        TEST(rc, P1_SUCCESS);
+    }
+    rc = P1_TryJoin(&pid, &status);
+    TEST(rc, P1_NO_QUIT);
+
+    rc = P1_JoinPid(pids[2], &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(status, 12);
+    TEST(numQuit, 3);
+    TEST(order[0], pids[0]);
+    TEST(order[2], pids[2]);
+
+    // reaped children are no longer ours
+    rc = P1_JoinPid(pids[2], &status);
+    TEST(rc, P1_INVALID_PID);
+
+    // a child that has already quit is reaped without blocking
+    rc = P1_JoinPid(pids[1], &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(status, 11);
+    rc = P1_TryJoin(&pid, &status);
+    TEST(rc, P1_SUCCESS);
+    TEST(pid, pids[0]);
+    TEST(status, 10);
+    rc = P1_TryJoin(&pid, &status);
+    TEST(rc, P1_NO_CHILDREN);
+    PASSED();
+    return 0;
+}
+
+void test_setup(int argc, char **argv) {}
+
+void test_cleanup(int argc, char **argv) {}
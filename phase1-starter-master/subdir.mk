@@ -63,6 +63,10 @@ LIBS += -l$(PHASE)-$(VERSION)
 # Change this if you want change which flags are passed to the C compiler.
 CFLAGS += -Wall -g -std=gnu99 -Werror -DPHASE=$(PHASE_UPPER) -D$(PHASE_UPPER) -DVERSION=$(VERSION) -DDATE="`date`"
 #CFLAGS += -DDEBUG
+# Uncomment to reserve context stacks with mmap, committed lazily and with a guard page.
+#CFLAGS += -DMMAP_STACKS
+# Uncomment to record scheduler events for tools/p1trace.
+#CFLAGS += -DP1_TRACE
 
 # You shouldn't need to change anything below here. 
 
@@ -134,7 +138,7 @@ $(TESTS):   %: $(TARGET) %.o $(STUBS)
 	$(LD) $(LDFLAGS) -o $@ $@.o $(STUBS) $(LIBFLAGS)
 
 clean:
-	rm -f $(COBJS) $(TARGET) $(TOBJS) $(TESTS) $(DEPS) $(TDEPS) $(TVS) $(STUBS) *.out tests/*.out tests/*.err
+	rm -f $(COBJS) $(TARGET) $(TOBJS) $(TESTS) $(DEPS) $(TDEPS) $(TVS) $(STUBS) *.out *.bin tests/*.out tests/*.err
 
 %.d: %.c
 	$(CC) -c $(CFLAGS) -MM -MF $@ $<
@@ -49,18 +49,23 @@ ErrorCodeToString(int code)
 static void
 DumpProcesses(void)
 {
+    static P1_ProcSnapshot procs[P1_MAXPROC_LIMIT];
+    int count;
+
+    int rc = P1_SnapshotProcesses(procs, P1_MAXPROC_LIMIT, P1_SNAP_ALL, &count);
+    if (rc != P1_SUCCESS) {
+        return;
+    }
     USLOSS_Console("%10s %3s %8s %3s %4s %3s %3s %3s %s\n", "Name", "PID", "State", "Pri", "CPU", "LID", "VID", "Par", "Children");
-    for (int i = 0; i < P1_MAXPROC; i++) {
-        P1_ProcInfo info;
-        memset(&info, '\0', sizeof(info));
-        int rc = P1_GetProcInfo(i, &info);
-        if ((rc == P1_SUCCESS) && (info.state != P1_STATE_FREE)) {
-            USLOSS_Console("%10s %3d %8s %3d %4d %3d %3d %3d ", info.name, i, states[info.state], info.priority, info.cpu, info.lid, info.vid, info.parent);
-            for (int j = 0; j < info.numChildren; j++) {
-              USLOSS_Console("%d ", info.children[j]);
+    for (int i = 0; i < count; i++) {
+        P1_ProcSnapshot *p = &procs[i];
+        USLOSS_Console("%10s %3d %8s %3d %4d %3d %3d %3d ", p->name, p->pid, states[p->state], p->priority, p->cpu, p->lid, p->vid, p->parent);
+        for (int j = 0; j < count; j++) {
+            if (procs[j].parent == p->pid) {
+              USLOSS_Console("%d ", procs[j].pid);
             }
-            USLOSS_Console("\n");
         }
+        USLOSS_Console("\n");
     }
 }
 
@@ -0,0 +1,258 @@
+/*
+ * Decodes a scheduler trace written by P1TraceDump.
+ *
+ *      p1trace [-j chrome.json] trace.bin
+ *
+ * Prints a timeline for each process and optionally writes the trace in Chrome's
+ * trace event format, which chrome://tracing and Perfetto can display. Each process
+ * is a thread, and each interval it ran is a slice.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "phase1Trace.h"
+
+#define MAX_PIDS 4096           // distinct PIDs tracked
+
+static char *reasons[] = {"start", "preempt", "rotate", "block", "exit"};
+static char *states[] = {"Free", "Run", "Ready", "Quit", "Block", "Join"};
+
+static P1TraceEvent *events;
+static int          numEvents;
+static unsigned int base;       // time of the first event
+static int          pids[MAX_PIDS]; // PIDs in the order they first appear
+static int          numPids;
+
+static char *
+Name(char **names, int count, int i)
+{
+    return ((i >= 0) && (i < count)) ? names[i] : "?";
+}
+
+// Time relative to the first event, in milliseconds.
+static double
+Ms(unsigned int time)
+{
+    return (time - base) / 1000.0;
+}
+
+static int
+Load(char *path)
+{
+    P1TraceHeader header;
+    int result = -1;
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    if ((fread(&header, sizeof(header), 1, f) != 1) || (header.magic != P1_TRACE_MAGIC)) {
+        fprintf(stderr, "%s: not a trace file\n", path);
+        goto done;
+    }
+    if (header.version != P1_TRACE_VERSION) {
+        fprintf(stderr, "%s: unsupported version %u\n", path, header.version);
+        goto done;
+    }
+    events = malloc(header.count * sizeof(P1TraceEvent));
+    if ((events == NULL) || (fread(events, sizeof(P1TraceEvent), header.count, f) != header.count)) {
+        fprintf(stderr, "%s: truncated trace\n", path);
+        free(events);
+        events = NULL;
+        goto done;
+    }
+    numEvents = header.count;
+    base = (numEvents > 0) ? events[0].time : 0;
+    printf("%d events", numEvents);
+    if (header.dropped > 0) {
+        printf(", %u earlier events were overwritten", header.dropped);
+    }
+    printf("\n");
+    result = 0;
+done:
+    fclose(f);
+    return result;
+}
+
+// Returns TRUE if the event concerns process pid.
+static int
+Involves(P1TraceEvent *event, int pid)
+{
+    switch (event->type) {
+        case P1_TRACE_SWITCH:
+        case P1_TRACE_FORK:
+            return (event->pid == pid) || (event->other == pid);
+        default:
+            return event->pid == pid;
+    }
+}
+
+/*
+ * Returns pid's index in pids, adding it if it's new. PIDs carry their slot's
+ * generation, so they are sparse. Returns -1 for -1 or if pids is full.
+ */
+static int
+Index(int pid)
+{
+    int i;
+
+    if (pid < 0) {
+        return -1;
+    }
+    for (i = 0; i < numPids; i++) {
+        if (pids[i] == pid) {
+            return i;
+        }
+    }
+    if (numPids == MAX_PIDS) {
+        return -1;
+    }
+    pids[numPids] = pid;
+    return numPids++;
+}
+
+static void
+Timeline(void)
+{
+    static unsigned int start[MAX_PIDS];
+    static double running[MAX_PIDS];
+    int pid;
+
+    for (int i = 0; i < numEvents; i++) {
+        Index(events[i].pid);
+        if ((events[i].type == P1_TRACE_SWITCH) || (events[i].type == P1_TRACE_FORK)) {
+            Index(events[i].other);
+        }
+    }
+    for (int p = 0; p < numPids; p++) {
+        pid = pids[p];
+        printf("\nprocess %d\n", pid);
+        for (int i = 0; i < numEvents; i++) {
+            P1TraceEvent *event = &events[i];
+            if (!Involves(event, pid)) {
+                continue;
+            }
+            printf("%12.3f ms  ", Ms(event->time));
+            switch (event->type) {
+                case P1_TRACE_SWITCH:
+                    if (event->other == pid) {
+                        start[p] = event->time;
+                        printf("runs (%s)\n", Name(reasons, 5, event->arg));
+                    } else {
+                        running[p] += (event->time - start[p]) / 1000.0;
+                        printf("switched out for %d (%s)\n", event->other, Name(reasons, 5, event->arg));
+                    }
+                    break;
+                case P1_TRACE_STATE:
+                    printf("%s -> %s\n", Name(states, 6, event->other), Name(states, 6, event->arg));
+                    break;
+                case P1_TRACE_FORK:
+                    if (event->pid == pid) {
+                        printf("forks %d at priority %d\n", event->other, event->arg);
+                    } else {
+                        printf("forked by %d at priority %d\n", event->pid, event->arg);
+                    }
+                    break;
+                case P1_TRACE_QUIT:
+                    printf("quits with status %d\n", event->other);
+                    break;
+                default:
+                    printf("unknown event %d\n", event->type);
+                    break;
+            }
+        }
+        printf("%12s     ran %.3f ms in this trace\n", "", running[p]);
+    }
+}
+
+static int
+Chrome(char *path)
+{
+    static unsigned int start[MAX_PIDS];
+    static int running[MAX_PIDS];
+    FILE *f = fopen(path, "w");
+    char *sep = "";
+    int out, in;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (int i = 0; i < numEvents; i++) {
+        P1TraceEvent *event = &events[i];
+        unsigned int ts = event->time - base;
+        switch (event->type) {
+            case P1_TRACE_SWITCH:
+                out = Index(event->pid);
+                in = Index(event->other);
+                if ((out != -1) && running[out]) {
+                    fprintf(f, "%s{\"name\":\"run\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%u,\"dur\":%u,"
+                            "\"args\":{\"out\":\"%s\",\"next\":%d}}", sep, event->pid,
+                            start[out] - base, event->time - start[out],
+                            Name(reasons, 5, event->arg), event->other);
+                    sep = ",\n";
+                    running[out] = 0;
+                }
+                if (in != -1) {
+                    start[in] = event->time;
+                    running[in] = 1;
+                }
+                break;
+            case P1_TRACE_STATE:
+                fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%u,"
+                        "\"args\":{\"from\":\"%s\"}}", sep, Name(states, 6, event->arg), event->pid, ts,
+                        Name(states, 6, event->other));
+                sep = ",\n";
+                break;
+            case P1_TRACE_FORK:
+                fprintf(f, "%s{\"name\":\"fork\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%u,"
+                        "\"args\":{\"child\":%d,\"priority\":%d}}", sep, event->pid, ts, event->other,
+                        event->arg);
+                sep = ",\n";
+                break;
+            case P1_TRACE_QUIT:
+                fprintf(f, "%s{\"name\":\"quit\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%u,"
+                        "\"args\":{\"status\":%d}}", sep, event->pid, ts, event->other);
+                sep = ",\n";
+                break;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f);
+}
+
+int
+main(int argc, char **argv)
+{
+    char *json = NULL;
+    int c;
+
+    while ((c = getopt(argc, argv, "j:")) != -1) {
+        switch (c) {
+            case 'j':
+                json = optarg;
+                break;
+            default:
+                goto usage;
+        }
+    }
+    if (optind != argc - 1) {
+        goto usage;
+    }
+    if (Load(argv[optind]) != 0) {
+        return 1;
+    }
+    Timeline();
+    if ((json != NULL) && (Chrome(json) != 0)) {
+        perror(json);
+        return 1;
+    }
+    return 0;
+usage:
+    fprintf(stderr, "usage: %s [-j chrome.json] trace.bin\n", argv[0]);
+    return 1;
+}